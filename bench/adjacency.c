@@ -0,0 +1,148 @@
+#include "adjacentPairs.h"
+#include "../src/generate.h"
+#include "../src/parse.h"
+#include "../src/pdToConwayTangles.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+  Finds the mergeable clock pairs of every crossing of sums of rational
+  tangles of 1000 crossings and more, three ways: the two getTangle2 calls
+  per pair the merge sweeps made, adjacentPairsScalar, and adjacentPairs,
+  which runs the AVX2 kernel where the machine has it:
+
+    make bench && bench/adjacency [maxCrossings]
+
+  Crossings are handed over in blocks of 8, as the sweeps do, and the three
+  must agree on every mask. Times are ns per crossing.
+*/
+
+#define MIN_SECONDS 0.2
+#define BLOCK 8
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* The masks the sweeps found with getTangle2, one clock pair at a time */
+static void getTangle2Pairs(int rows, tangleInt pdCode[][7], int edge[][4], const int tangles[],
+                            int count, unsigned char masks[]) {
+  for (int i = 0; i < count; i++) {
+    int mask = 0;
+    for (int k = 0; k < 4; k++) {
+      int tangle2i, tangle2ii, clock2i, clock2ii;
+      getTangle2(rows, tangles[i], k, &tangle2i, &clock2i, pdCode, edge);
+      getTangle2(rows, tangles[i], (k + 1) % 4, &tangle2ii, &clock2ii, pdCode, edge);
+      if (tangle2i == tangle2ii && tangle2i >= 0) {
+        mask |= 1 << k;
+      }
+    }
+    masks[i] = mask;
+  }
+}
+
+typedef void (*pairKernel)(const uint64_t arcs[], int edge[][4], const int tangles[], int count,
+                           unsigned char masks[]);
+
+/* ns per crossing of one kernel over all rows, blocks of BLOCK at a time */
+static double timeKernel(pairKernel kernel, int rows, tangleInt pdCode[][7], const uint64_t arcs[],
+                         int edge[][4], const int tangles[], unsigned char masks[]) {
+  long reps = 0;
+  double start = now();
+  do {
+    for (int i = 0; i < rows; i += BLOCK) {
+      int count = rows - i < BLOCK ? rows - i : BLOCK;
+      if (kernel == NULL) {
+        getTangle2Pairs(rows, pdCode, edge, tangles + i, count, masks + i);
+      } else {
+        kernel(arcs, edge, tangles + i, count, masks + i);
+      }
+    }
+    reps++;
+  } while (now() - start < MIN_SECONDS);
+  return (now() - start) * 1e9 / reps / rows;
+}
+
+static void benchSize(int target) {
+  char *record = NULL;
+  size_t recordLength = 0;
+  int pieces = target / 12 < 2 ? 2 : target / 12;
+
+  // [5 4 3] has 12 crossings
+  FILE *out = open_memstream(&record, &recordLength);
+  for (int i = 0; i < pieces; i++) {
+    fprintf(out, "%s[5 4 3]", i == 0 ? "" : "+");
+  }
+  fclose(out);
+  char *expression = record;
+  record = NULL;
+  out = open_memstream(&record, &recordLength);
+  if (out == NULL || generateExpression(out, expression) != 0) {
+    fprintf(stderr, "cannot build %d x [5 4 3]\n", pieces);
+    exit(1);
+  }
+  fclose(out);
+  free(expression);
+  record[strcspn(record, "\n")] = 0;
+  const char *pd = strrchr(record, '\t') + 1;
+
+  size_t length = strlen(pd);
+  int capacity = length / 9 + 1;
+  int rows = 0;
+  tangleInt (*pdCode)[7] = malloc(capacity * sizeof(*pdCode));
+  if (pdCode == NULL || parsePD(pd, length, pdCode, capacity, &rows) != PARSE_OK) {
+    fprintf(stderr, "generated PD code does not parse\n");
+    exit(1);
+  }
+  int (*edge)[4] = malloc((2 * rows + 2) * sizeof(*edge));
+  uint64_t *arcs = malloc(rows * sizeof(uint64_t));
+  int *tangles = malloc(rows * sizeof(int));
+  unsigned char *masks[3];
+  for (int k = 0; k < 3; k++) {
+    masks[k] = malloc(rows);
+  }
+  createEdge(rows, pdCode, edge);
+  for (int t = 0; t < rows; t++) {
+    arcs[t] = 0;
+    for (int c = 0; c < 4; c++) {
+      arcs[t] |= (uint64_t)pdCode[t][c] << (16 * c);
+    }
+    tangles[t] = t;
+  }
+
+  double loop = timeKernel(NULL, rows, pdCode, arcs, edge, tangles, masks[0]);
+  double scalar = timeKernel(adjacentPairsScalar, rows, pdCode, arcs, edge, tangles, masks[1]);
+  double vector = timeKernel(adjacentPairs, rows, pdCode, arcs, edge, tangles, masks[2]);
+  int agree = memcmp(masks[0], masks[1], rows) == 0 && memcmp(masks[0], masks[2], rows) == 0;
+  int candidates = 0;
+  for (int t = 0; t < rows; t++) {
+    candidates += masks[0][t] != 0;
+  }
+  printf("%10d %10.2f %10.2f %10.2f %9.2fx %11d%s\n", rows, loop, scalar, vector, loop / vector,
+         candidates, agree ? "" : "   MASKS DIFFER");
+
+  for (int k = 0; k < 3; k++) {
+    free(masks[k]);
+  }
+  free(tangles);
+  free(arcs);
+  free(edge);
+  free(pdCode);
+  free(record);
+}
+
+int main(int argc, char *argv[]) {
+  int maxCrossings = argc > 1 ? atoi(argv[1]) : 16384;
+
+  printf("adjacentPairs: %s kernel\n", adjacentPairsVector() ? "AVX2" : "scalar");
+  printf("%10s %10s %10s %10s %10s %11s   ns/crossing\n", "crossings", "getTangle2", "scalar",
+         "vector", "speedup", "candidates");
+  for (int target = 1024; target <= maxCrossings; target *= 2) {
+    benchSize(target);
+  }
+  return 0;
+}
@@ -0,0 +1,118 @@
+#include "adjacentPairs.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define ADJACENCY_AVX2
+#endif
+
+/* The crossing at the far end of arc from tangle, as getTangle2 finds it, or -1 */
+static int farEnd(int edge[][4], int arc, int tangle){
+  if(edge[arc][0] == tangle){
+    return edge[arc][2];
+  }
+  if(edge[arc][2] == tangle){
+    return edge[arc][0];
+  }
+  return -1;
+}
+
+/* adjacentPairs' mask for one tangle with arcs arc[0..3] by column */
+int adjacentMask(const int arc[4], int edge[][4], int tangle){
+  int other[4];
+  int mask = 0;
+
+  for(int c = 0; c < 4; c++){
+    other[c] = farEnd(edge, arc[c], tangle);
+  }
+  for(int k = 0; k < 4; k++){
+    if(other[k] >= 0 && other[k] == other[(k + 1) & 3]){
+      mask |= 1 << k;
+    }
+  }
+  return mask;
+}
+
+void adjacentPairsScalar(const uint64_t arcs[], int edge[][4], const int tangles[], int count,
+                         unsigned char masks[]){
+  for(int i = 0; i < count; i++){
+    uint64_t word = arcs[tangles[i]];
+    int arc[4];
+    for(int c = 0; c < 4; c++){
+      arc[c] = (int)(word >> (16 * c) & 0xffff);
+    }
+    masks[i] = adjacentMask(arc, edge, tangles[i]);
+  }
+}
+
+#ifdef ADJACENCY_AVX2
+/*
+  Eight tangles at a time: their words are gathered into two vectors and
+  each column's arcs packed into the eight ints of one, tangle i + m in
+  lane 2m and tangle i + 4 + m in lane 2m + 1. Both ends of those arcs are
+  gathered from edge and the far ends compared between neighbouring columns.
+*/
+__attribute__((target("avx2")))
+static void adjacentPairsAVX2(const uint64_t arcs[], int edge[][4], const int tangles[], int count,
+                              unsigned char masks[]){
+  const int *ends = &edge[0][0];
+  const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+  const __m256i low16 = _mm256_set1_epi64x(0xffff);
+  const __m256i none = _mm256_set1_epi32(-1);
+  int i = 0;
+
+  for(; i + 8 <= count; i += 8){
+    __m256i ids = _mm256_loadu_si256((const __m256i *)&tangles[i]);
+    __m256i words0 = _mm256_i32gather_epi64((const long long *)arcs, _mm256_castsi256_si128(ids), 8);
+    __m256i words1 = _mm256_i32gather_epi64((const long long *)arcs, _mm256_extracti128_si256(ids, 1), 8);
+    __m256i lanes = _mm256_permutevar8x32_epi32(ids, order);
+    __m256i other[4];
+
+    for(int c = 0; c < 4; c++){
+      __m128i shift = _mm_cvtsi32_si128(16 * c);
+      __m256i low = _mm256_and_si256(_mm256_srl_epi64(words0, shift), low16);
+      __m256i high = _mm256_and_si256(_mm256_srl_epi64(words1, shift), low16);
+      __m256i row = _mm256_slli_epi32(_mm256_or_si256(low, _mm256_slli_epi64(high, 32)), 2);
+      __m256i end0 = _mm256_i32gather_epi32(ends, row, 4);
+      __m256i end2 = _mm256_i32gather_epi32(ends + 2, row, 4);
+      __m256i at0 = _mm256_cmpeq_epi32(end0, lanes);
+      __m256i at2 = _mm256_cmpeq_epi32(end2, lanes);
+      other[c] = _mm256_blendv_epi8(_mm256_blendv_epi8(none, end0, at2), end2, at0);
+    }
+
+    int bits[4];
+    for(int k = 0; k < 4; k++){
+      __m256i same = _mm256_and_si256(_mm256_cmpeq_epi32(other[k], other[(k + 1) & 3]),
+                                      _mm256_cmpgt_epi32(other[k], none));
+      bits[k] = _mm256_movemask_ps(_mm256_castsi256_ps(same));
+    }
+    for(int lane = 0; lane < 8; lane++){
+      int mask = 0;
+      for(int k = 0; k < 4; k++){
+        mask |= (bits[k] >> lane & 1) << k;
+      }
+      masks[i + (lane >> 1) + 4 * (lane & 1)] = mask;
+    }
+  }
+  adjacentPairsScalar(arcs, edge, tangles + i, count - i, masks + i);
+}
+#endif
+
+/* Whether adjacentPairs runs the vector kernel on this machine */
+int adjacentPairsVector(void){
+#ifdef ADJACENCY_AVX2
+  return __builtin_cpu_supports("avx2");
+#else
+  return 0;
+#endif
+}
+
+void adjacentPairs(const uint64_t arcs[], int edge[][4], const int tangles[], int count,
+                   unsigned char masks[]){
+#ifdef ADJACENCY_AVX2
+  if(__builtin_cpu_supports("avx2")){
+    adjacentPairsAVX2(arcs, edge, tangles, count, masks);
+    return;
+  }
+#endif
+  adjacentPairsScalar(arcs, edge, tangles, count, masks);
+}
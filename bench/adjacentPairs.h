@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+  Finds the clock pairs the merge sweeps can act on: bit k of masks[i] is
+  set when the arcs in columns k and (k + 1) & 3 of tangle tangles[i] both
+  lead to the same crossing. arcs holds each tangle's four arcs 16 bits
+  apiece, column c in bits 16c to 16c + 15, and edge is the arc matrix.
+
+  The sweeps still look pairs up one tangle at a time. Most merges change
+  the pairs of the tangle tried next, so masks found a batch ahead had to
+  be found again so often that the sweeps ran about a third slower, so
+  the kernel lives here with bench/adjacency, its only caller, until a
+  sweep has a use for it.
+*/
+int adjacentMask(const int arc[4], int edge[][4], int tangle);
+void adjacentPairs(const uint64_t arcs[], int edge[][4], const int tangles[], int count,
+                   unsigned char masks[]);
+void adjacentPairsScalar(const uint64_t arcs[], int edge[][4], const int tangles[], int count,
+                         unsigned char masks[]);
+int adjacentPairsVector(void);
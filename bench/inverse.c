@@ -0,0 +1,133 @@
+#include "../src/util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+  Micro-benchmark of ainversemodb against the linear search it replaced,
+  and against reading the inverse off the convergents of b/a, for
+  numerators 10^3 up to 10^maxExponent (default 9):
+
+    make bench && bench/inverse [maxExponent]
+
+  The linear search tries every candidate below the numerator, so it gets
+  only enough calls to add up to about 10^8 candidates per size. Every
+  inverse the convergents give is checked against ainversemodb's.
+*/
+
+/* terms of the continued fraction of b/a < 1 for a up to 2*10^18, with room to spare */
+#define CONVERGENTS_MAX 100
+
+/* ainversemodb as it was before extended Euclid */
+static tangleInt linearInverse(tangleInt b, tangleInt a) {
+  tangleInt X = 0;
+  if (llabs(a)==1){
+    return a;
+  } else if (a < -1){
+    for(tangleInt i = -1; i > a; i--){
+      if((i * b - 1)  % a == 0){
+        X = i - a;
+      }
+    }
+  }
+  else {
+    for (tangleInt i = 1; i < a; i++) {
+      if ((i * b - 1) % a == 0){
+        X = i;
+      }
+    }
+  }
+  return X;
+}
+
+/*
+  The inverse of b mod a > 1 from the convergents p[k]/q[k] of b/a: the last
+  is b/a itself, and p[n-1]*q[n-2] - p[n-2]*q[n-1] = (-1)^n makes
+  b*q[n-2] = (-1)^n (mod a).
+*/
+static tangleInt convergentInverse(tangleInt b, tangleInt a) {
+  tangleInt p[CONVERGENTS_MAX], q[CONVERGENTS_MAX];
+  int n = convergents(b, a, p, q, CONVERGENTS_MAX);
+  tangleInt previous = n > 1 ? q[n - 2] : 0;
+  return aModB(n % 2 == 0 ? previous : -previous, a);
+}
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static tangleInt gcd(tangleInt a, tangleInt b) {
+  while (b != 0) {
+    tangleInt t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+/* numerators a in [scale, 2*scale) with a denominator b < a coprime to it */
+static void makePairs(tangleInt scale, int count, tangleInt a[], tangleInt b[]) {
+  for (int i = 0; i < count; i++) {
+    do {
+      a[i] = scale + (tangleInt)(((double)rand() / RAND_MAX) * (scale - 1));
+      b[i] = 1 + (tangleInt)(((double)rand() / RAND_MAX) * (a[i] - 2));
+    } while (gcd(a[i], b[i]) != 1);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  int maxExponent = argc > 1 ? atoi(argv[1]) : 9;
+  enum { EUCLID_CALLS = 1000000 };
+  static tangleInt a[EUCLID_CALLS], b[EUCLID_CALLS];
+  tangleInt check = 0;
+
+  srand(1);
+  printf("%12s %16s %16s %16s %10s\n", "numerator", "linear ns/call",
+         "euclid ns/call", "convergent ns", "speedup");
+  tangleInt scale = 1000;
+  for (int e = 3; e <= maxExponent; e++, scale *= 10) {
+    makePairs(scale, EUCLID_CALLS, a, b);
+
+    static tangleInt inverse[EUCLID_CALLS];
+    double start = now();
+    for (int i = 0; i < EUCLID_CALLS; i++) {
+      if (ainversemodb(b[i], a[i], &inverse[i]) != 0) {
+        printf("no inverse of %lld mod %lld\n", b[i], a[i]);
+        return 1;
+      }
+      check += inverse[i];
+    }
+    double euclid = (now() - start) / EUCLID_CALLS;
+
+    start = now();
+    for (int i = 0; i < EUCLID_CALLS; i++) {
+      tangleInt x = convergentInverse(b[i], a[i]);
+      if (x != inverse[i]) {
+        printf("inverse of %lld mod %lld from convergents differs: %lld\n", b[i], a[i], x);
+        return 1;
+      }
+    }
+    double convergent = (now() - start) / EUCLID_CALLS;
+
+    int linearCalls = (int)(100000000 / scale);
+    if (linearCalls < 1) {
+      linearCalls = 1;
+    }
+    start = now();
+    for (int i = 0; i < linearCalls; i++) {
+      tangleInt x = linearInverse(b[i], a[i]);
+      if (x != inverse[i]) {
+        printf("inverse of %lld mod %lld differs: %lld\n", b[i], a[i], x);
+        return 1;
+      }
+    }
+    double linear = (now() - start) / linearCalls;
+
+    printf("%12lld %16.0f %16.1f %16.1f %9.0fx\n", scale, linear * 1e9,
+           euclid * 1e9, convergent * 1e9, linear / euclid);
+  }
+  // keep the Euclid loop from being optimised away
+  return check == 0;
+}
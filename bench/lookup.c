@@ -0,0 +1,160 @@
+#include "../src/canonical.h"
+#include "../src/generate.h"
+#include "../src/lookup.h"
+#include "../src/output.h"
+#include "../src/pdToConwayTangles.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+  Times the answer for each tangle of up to a table's crossings, by crossing
+  count, reduced by pdToConwayArena and looked up with lookupPD:
+
+    make table bench && bench/lookup tangles.table [sample]
+
+  Every sample-th code generateDiagrams writes (default 64) is kept, and the
+  lookup must give the result reducing its canonical form does, as -c would.
+  Times are ns per tangle, the canonical form and hash included in lookups.
+*/
+
+#define MIN_SECONDS 0.2
+#define MAX_ROWS 16
+
+typedef struct sampleCodes {
+  tangleInt (*codes)[MAX_ROWS][7];
+  int *rows;
+  long count;
+  long capacity;
+  long seen;
+  long sample;
+} sampleCodes;
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void keepCode(void *context, const char *name, int shape, int rows, tangleInt pdCode[][7]) {
+  sampleCodes *s = context;
+
+  (void)name;
+  (void)shape;
+  if (s->seen++ % s->sample != 0 || rows > MAX_ROWS) {
+    return;
+  }
+  if (s->count == s->capacity) {
+    s->capacity = s->capacity > 0 ? 2 * s->capacity : 1024;
+    s->codes = realloc(s->codes, s->capacity * sizeof(*s->codes));
+    s->rows = realloc(s->rows, s->capacity * sizeof(int));
+    if (s->codes == NULL || s->rows == NULL) {
+      perror("keepCode");
+      exit(1);
+    }
+  }
+  memcpy(s->codes[s->count], pdCode, rows * sizeof(*pdCode));
+  s->rows[s->count++] = rows;
+}
+
+/* Whether two results would be written out the same */
+static int sameResult(const tangleResult *a, const tangleResult *b) {
+  char *text[2] = {NULL, NULL};
+  size_t length[2];
+  const tangleResult *results[2] = {a, b};
+
+  for (int i = 0; i < 2; i++) {
+    FILE *out = open_memstream(&text[i], &length[i]);
+    writeResult(out, FORMAT_JSON, results[i]);
+    fclose(out);
+  }
+  int same = length[0] == length[1] && memcmp(text[0], text[1], length[0]) == 0;
+  free(text[0]);
+  free(text[1]);
+  return same;
+}
+
+int main(int argc, char *argv[]) {
+  lookupTable table;
+  sampleCodes s = {0};
+  arena scratch;
+  tangleResult *reduced = malloc(sizeof(tangleResult));
+  tangleResult *found = malloc(sizeof(tangleResult));
+
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s table [sample]\n", argv[0]);
+    return 1;
+  }
+  if (lookupOpen(&table, argv[1]) != 0) {
+    perror(argv[1]);
+    return 1;
+  }
+  s.sample = argc > 2 ? atol(argv[2]) : 64;
+  if (s.sample < 1) {
+    s.sample = 1;
+  }
+  int maxCrossings = table.header->maxCrossings;
+  arenaInit(&scratch);
+  if (generateDiagrams(maxCrossings, keepCode, &s) < 0) {
+    perror("generateDiagrams");
+    return 1;
+  }
+
+  long missing = 0, differ = 0;
+  for (long i = 0; i < s.count; i++) {
+    tangleInt canonical[MAX_ROWS][7];
+    memcpy(canonical, s.codes[i], s.rows[i] * sizeof(*canonical));
+    canonicalPD(s.rows[i], canonical, &scratch);
+    pdToConwayArena(s.rows[i], canonical, reduced, &scratch);
+    if (lookupPD(&table, s.rows[i], s.codes[i], &scratch, found) != 0) {
+      missing++;
+    } else if (!sameResult(reduced, found)) {
+      differ++;
+    }
+  }
+
+  printf("%ld of %ld codes kept, %ld missing from %s, %ld differ\n", s.count, s.seen, missing,
+         argv[1], differ);
+  printf("%10s %10s %12s %12s %10s   ns/tangle\n", "crossings", "codes", "reduce", "lookup",
+         "speedup");
+  long *picked = malloc(s.count * sizeof(long));
+  for (int c = 1; c <= maxCrossings; c++) {
+    double ns[2];
+    long codes = 0;
+    for (long i = 0; i < s.count; i++) {
+      if (s.rows[i] == c) {
+        picked[codes++] = i;
+      }
+    }
+    for (int way = 0; way < 2 && codes > 0; way++) {
+      long reps = 0;
+      double start = now();
+      do {
+        for (long p = 0; p < codes; p++) {
+          long i = picked[p];
+          if (way == 0) {
+            tangleInt work[MAX_ROWS][7];
+            memcpy(work, s.codes[i], s.rows[i] * sizeof(*work));
+            pdToConwayArena(s.rows[i], work, reduced, &scratch);
+          } else {
+            lookupPD(&table, s.rows[i], s.codes[i], &scratch, found);
+          }
+          reps++;
+        }
+      } while (now() - start < MIN_SECONDS);
+      ns[way] = (now() - start) * 1e9 / reps;
+    }
+    if (codes > 0) {
+      printf("%10d %10ld %12.0f %12.0f %9.1fx\n", c, codes, ns[0], ns[1], ns[0] / ns[1]);
+    }
+  }
+  arenaFree(&scratch);
+  lookupClose(&table);
+  free(picked);
+  free(s.codes);
+  free(s.rows);
+  free(reduced);
+  free(found);
+  return missing > 0 || differ > 0;
+}
@@ -0,0 +1,92 @@
+#include "../src/reader.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+  Throughput of splitting a PD table into lines, with the block reader
+  batch mode uses and with the getline loop it replaced:
+
+    make bench && bench/reader pdCodes.txt
+
+  Each pass touches every line so neither can skip work. Run it twice, or
+  on a file larger than memory, to tell disk bandwidth from page cache.
+*/
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static long maxResidentKB(void) {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+static void report(const char *name, long lines, size_t bytes, unsigned sum, double seconds) {
+  printf("%-8s %10ld lines %8.1f MB in %6.3f s, %8.1f MB/s (checksum %08x, max RSS %ld KB)\n",
+         name, lines, bytes / 1e6, seconds, seconds > 0 ? bytes / 1e6 / seconds : 0.0, sum,
+         maxResidentKB());
+}
+
+int main(int argc, char *argv[]) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s file\n", argv[0]);
+    return 1;
+  }
+
+  int fd = open(argv[1], O_RDONLY);
+  inputReader reader;
+  if (fd < 0 || readerInit(&reader, fd) != 0) {
+    perror(argv[1]);
+    return 1;
+  }
+  long lines = 0;
+  size_t bytes = 0;
+  unsigned sum = 0;
+  double start = now();
+  int filled;
+  while ((filled = readerFill(&reader)) > 0) {
+    char *line;
+    size_t length;
+    while ((line = readerLine(&reader, &length)) != NULL) {
+      lines++;
+      bytes += length + 1;
+      sum = sum * 31 + (length > 0 ? (unsigned char)line[length - 1] : 0);
+    }
+  }
+  report("reader", lines, bytes, sum, now() - start);
+  readerFree(&reader);
+  close(fd);
+
+  FILE *in = fopen(argv[1], "r");
+  if (in == NULL) {
+    perror(argv[1]);
+    return 1;
+  }
+  char *line = NULL;
+  size_t cap = 0;
+  ssize_t length;
+  lines = 0;
+  bytes = 0;
+  sum = 0;
+  start = now();
+  while ((length = getline(&line, &cap, in)) != -1) {
+    if (length > 0 && line[length - 1] == '\n') {
+      line[--length] = 0;
+    }
+    lines++;
+    bytes += length + 1;
+    sum = sum * 31 + (length > 0 ? (unsigned char)line[length - 1] : 0);
+  }
+  report("getline", lines, bytes, sum, now() - start);
+  free(line);
+  fclose(in);
+  return 0;
+}
@@ -0,0 +1,224 @@
+#include "../src/generate.h"
+#include "../src/parse.h"
+#include "../src/pdToConwayTangles.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+  Times each stage of the reduction on rational, Montesinos and algebraic
+  tangles of 4 up to maxCrossings (default 4096) crossings, doubling:
+
+    make bench && bench/stages [maxCrossings]
+
+  Every size is reduced until a tenth of a second has gone by and the stages
+  are reported in ns per crossing. The least squares slope of log time
+  against log crossings, over the tangles of 32 crossings or more, is the
+  scaling exponent of each stage; one above 1.5 is flagged, as it means a
+  stage has gone quadratic.
+*/
+
+#define MIN_SECONDS 0.1
+#define FIT_FROM 32
+#define FLAG_EXPONENT 1.5
+#define MAX_SIZES 32
+
+static const char *columns[STAGES] = {
+  "parse", "edge", "writhe", "simplify", "horV", "ratSimple", "remove", "sort", "orient", "algTangle"
+};
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Appends to a growing string, exiting when memory runs out */
+static void append(char **text, size_t *length, const char *piece) {
+  size_t more = strlen(piece);
+  *text = realloc(*text, *length + more + 1);
+  if (*text == NULL) {
+    perror("append");
+    exit(1);
+  }
+  memcpy(*text + *length, piece, more + 1);
+  *length += more;
+}
+
+/* A Conway vector of four equal terms: long twists, few merges of rationals */
+static void rationalExpression(int crossings, char **text, size_t *length) {
+  char piece[64];
+  int term = crossings / 4 < 2 ? 2 : crossings / 4;
+  snprintf(piece, sizeof(piece), "[%d %d %d %d]", term, term, term,
+           crossings - 3 * term > 0 ? crossings - 3 * term : 1);
+  append(text, length, piece);
+}
+
+/* A sum of 4 crossing rational tangles, at least three of them */
+static void montesinosExpression(int crossings, char **text, size_t *length) {
+  int pieces = crossings / 4 < 3 ? 3 : crossings / 4;
+  for (int i = 0; i < pieces; i++) {
+    append(text, length, i == 0 ? "" : "+");
+    append(text, length, i % 2 ? "[2 1 1]" : "[3 1 0]");
+  }
+}
+
+/* Sums of products of sums ... of 3 crossing rational tangles, as a balanced tree */
+static void treeExpression(int levels, int sum, char **text, size_t *length) {
+  if (levels == 0) {
+    append(text, length, "[2 1]");
+    return;
+  }
+  append(text, length, "(");
+  treeExpression(levels - 1, !sum, text, length);
+  append(text, length, sum ? "+" : "*");
+  treeExpression(levels - 1, !sum, text, length);
+  append(text, length, ")");
+}
+
+static void algebraicExpression(int crossings, char **text, size_t *length) {
+  int levels = 2;
+  while (3 << (levels + 1) <= crossings) {
+    levels++;
+  }
+  treeExpression(levels, 1, text, length);
+}
+
+typedef void (*familyExpression)(int crossings, char **text, size_t *length);
+
+/* Mean ns per tangle of each stage, plus the total, for one tangle */
+static int timeTangle(const char *pd, double stageNs[STAGES + 1], arena *scratch) {
+  size_t length = strlen(pd);
+  int capacity = length / 9 + 1;
+  tangleInt (*pdCode)[7] = malloc(capacity * sizeof(*pdCode));
+  tangleResult *result = malloc(sizeof(tangleResult));
+  long long totals[STAGES] = {0};
+  long reps = 0;
+  int rows = 0;
+
+  if (pdCode == NULL || result == NULL) {
+    perror("timeTangle");
+    exit(1);
+  }
+  double start = now();
+  do {
+    double parseStart = now();
+    if (parsePD(pd, length, pdCode, capacity, &rows) != PARSE_OK) {
+      fprintf(stderr, "generated PD code does not parse\n");
+      exit(1);
+    }
+    totals[STAGE_PARSE] += (long long)((now() - parseStart) * 1e9);
+    pdToConwayArena(rows, pdCode, result, scratch);
+    for (int s = STAGE_PARSE + 1; s < STAGES; s++) {
+      totals[s] += result->stats.stageNanos[s];
+    }
+    reps++;
+  } while (now() - start < MIN_SECONDS || reps < 3);
+
+  stageNs[STAGES] = 0;
+  for (int s = 0; s < STAGES; s++) {
+    stageNs[s] = (double)totals[s] / reps;
+    stageNs[STAGES] += stageNs[s];
+  }
+  free(pdCode);
+  free(result);
+  return rows;
+}
+
+/* Least squares slope of log y against log x over the points with x >= FIT_FROM */
+static double exponent(const int x[], double y[][STAGES + 1], int stage, int count) {
+  double sx = 0, sy = 0, sxx = 0, sxy = 0;
+  int n = 0;
+
+  for (int i = 0; i < count; i++) {
+    if (x[i] < FIT_FROM || y[i][stage] <= 0) {
+      continue;
+    }
+    double lx = log(x[i]);
+    double ly = log(y[i][stage]);
+    sx += lx;
+    sy += ly;
+    sxx += lx * lx;
+    sxy += lx * ly;
+    n++;
+  }
+  if (n < 2 || n * sxx - sx * sx == 0) {
+    return NAN;
+  }
+  return (n * sxy - sx * sy) / (n * sxx - sx * sx);
+}
+
+static void benchFamily(const char *family, familyExpression expression, int maxCrossings,
+                        arena *scratch) {
+  int crossings[MAX_SIZES];
+  double stageNs[MAX_SIZES][STAGES + 1];
+  int sizes = 0;
+
+  printf("%s\n%10s", family, "crossings");
+  for (int s = 0; s < STAGES; s++) {
+    printf(" %10s", columns[s]);
+  }
+  printf(" %10s   ns/crossing\n", "total");
+
+  char *last = NULL;
+  for (int target = 4; target <= maxCrossings && sizes < MAX_SIZES; target *= 2) {
+    char *text = NULL;
+    size_t length = 0;
+    char *record = NULL;
+    size_t recordLength = 0;
+    expression(target, &text, &length);
+    // Small targets can round up to the same tangle
+    if (last != NULL && strcmp(text, last) == 0) {
+      free(text);
+      continue;
+    }
+    free(last);
+    last = text;
+    FILE *out = open_memstream(&record, &recordLength);
+    if (out == NULL || generateExpression(out, text) != 0) {
+      fprintf(stderr, "cannot build %s\n", text);
+      exit(1);
+    }
+    fclose(out);
+    record[strcspn(record, "\n")] = 0;
+    const char *pd = strrchr(record, '\t') + 1;
+
+    crossings[sizes] = timeTangle(pd, stageNs[sizes], scratch);
+    printf("%10d", crossings[sizes]);
+    for (int s = 0; s <= STAGES; s++) {
+      printf(" %10.1f", stageNs[sizes][s] / crossings[sizes]);
+    }
+    printf("\n");
+    fflush(stdout);
+    sizes++;
+    free(record);
+  }
+  free(last);
+
+  printf("%10s", "exponent");
+  for (int s = 0; s <= STAGES; s++) {
+    double e = exponent(crossings, stageNs, s, sizes);
+    if (isnan(e)) {
+      printf(" %10s", "-");
+    } else {
+      printf(" %9.2f%c", e, e > FLAG_EXPONENT ? '!' : ' ');
+    }
+  }
+  printf("\n\n");
+}
+
+int main(int argc, char *argv[]) {
+  int maxCrossings = argc > 1 ? atoi(argv[1]) : 4096;
+  arena scratch;
+
+  arenaInit(&scratch);
+  benchFamily("rational", rationalExpression, maxCrossings, &scratch);
+  benchFamily("montesinos", montesinosExpression, maxCrossings, &scratch);
+  benchFamily("algebraic", algebraicExpression, maxCrossings, &scratch);
+  arenaFree(&scratch);
+  printf("exponents over tangles of %d crossings or more, ! above %.1f\n",
+         FIT_FROM, FLAG_EXPONENT);
+  return 0;
+}
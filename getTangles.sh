@@ -3,11 +3,5 @@ file="pdCodes.txt"
 
 echo "PD to Conway Tangles Results;" > tangle_out.csv
 
-while IFS=$'\t' read -r twist frac pd
-do
-    [ -z "$pd" ] && continue;
-    printf "%s\n" "$frac"
-    printf "%s,%s," "$twist" "$frac">>tangle_out.csv
-    ./pdToConwayTangles "$pd" >>tangle_out.csv
-    echo ";" >>tangle_out.csv
-done <$file
+# Batch mode reduces every record of $file in a single process
+./pdToConwayTangles -b "$file" >>tangle_out.csv
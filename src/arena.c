@@ -0,0 +1,92 @@
+#include "arena.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+struct arenaBlock {
+  arenaBlock *next;
+  size_t size;
+  size_t used;
+  char bytes[] __attribute__((aligned(ARENA_ALIGN)));
+};
+
+void arenaInit(arena *a) {
+  a->base = NULL;
+  a->size = 0;
+  a->used = 0;
+  a->spill = NULL;
+  a->spilled = 0;
+}
+
+static void freeSpill(arena *a) {
+  while (a->spill != NULL) {
+    arenaBlock *next = a->spill->next;
+    free(a->spill);
+    a->spill = next;
+  }
+  a->spilled = 0;
+}
+
+/*
+  Frees everything handed out so far and makes sure size bytes are
+  available, or as many as were handed out since the last reset if that is
+  more. Returns 0, or -1 when the arena could not be grown.
+*/
+int arenaReset(arena *a, size_t size) {
+  size_t wanted = a->used + a->spilled;
+  if (wanted < size) {
+    wanted = size;
+  }
+  freeSpill(a);
+  a->used = 0;
+  if (wanted <= a->size) {
+    return 0;
+  }
+  free(a->base);
+  a->base = malloc(wanted);
+  if (a->base == NULL) {
+    a->size = 0;
+    return -1;
+  }
+  a->size = wanted;
+  return 0;
+}
+
+/* An allocation base has no room for, from the newest spill block or a new one */
+static void *spillAlloc(arena *a, size_t bytes) {
+  if (bytes > SIZE_MAX - sizeof(arenaBlock) - ARENA_ALIGN) {
+    return NULL;
+  }
+  size_t rounded = (bytes + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+  arenaBlock *block = a->spill;
+  if (block == NULL || rounded > block->size - block->used) {
+    size_t size = rounded > a->size ? rounded : a->size;
+    block = malloc(sizeof(arenaBlock) + size);
+    if (block == NULL) {
+      return NULL;
+    }
+    block->next = a->spill;
+    block->size = size;
+    block->used = 0;
+    a->spill = block;
+  }
+  void *p = block->bytes + block->used;
+  block->used += rounded;
+  a->spilled += rounded;
+  return p;
+}
+
+/* Returns bytes of scratch, or NULL when no memory was left to take them from */
+void *arenaAlloc(arena *a, size_t bytes) {
+  size_t start = (a->used + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+  if (start > a->size || bytes > a->size - start) {
+    return spillAlloc(a, bytes);
+  }
+  a->used = start + bytes;
+  return a->base + start;
+}
+
+void arenaFree(arena *a) {
+  freeSpill(a);
+  free(a->base);
+  arenaInit(a);
+}
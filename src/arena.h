@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stddef.h>
+
+/* Every allocation starts on this boundary */
+#define ARENA_ALIGN 16
+
+typedef struct arenaBlock arenaBlock;
+
+/*
+  Scratch memory handed out front to back and given back all at once. A
+  worker keeps one arena for its whole run; arenaReset only grows it when a
+  tangle needs more than any before it, so steady state does no allocation.
+  The size passed to arenaReset is what a tangle is expected to take. An
+  allocation past it does not fail but spills into a block of its own, and
+  the next arenaReset grows the arena to cover what spilled.
+*/
+typedef struct arena {
+  char *base;
+  size_t size;
+  size_t used;
+  arenaBlock *spill;   // blocks taken since the last reset, newest first
+  size_t spilled;      // bytes handed out from them
+} arena;
+
+void arenaInit(arena *a);
+int arenaReset(arena *a, size_t size);
+void *arenaAlloc(arena *a, size_t bytes);
+void arenaFree(arena *a);
@@ -0,0 +1,589 @@
+#include "batch.h"
+#include "cache.h"
+#include "canonical.h"
+#include "lookup.h"
+#include "output.h"
+#include "parse.h"
+#include "reader.h"
+#include "stats.h"
+#include "store.h"
+#include "trace.h"
+#include "pdToConwayTangles.h"
+#include "util.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/*
+  Splits a record the same way `read -r twist frac pd` does in getTangles.sh
+  with IFS set to a tab: runs of tabs separate fields, leading and trailing
+  tabs are dropped, and whatever follows the second field is the PD code.
+  Returns 0 when the record has no PD code and should be skipped.
+*/
+static int splitRecord(char *line, char **twist, char **frac, char **pd){
+  char *c = line;
+  char *fields[2] = {c, c};
+
+  for(int i = 0; i < 2; i++){
+    while(*c == '\t'){
+      c++;
+    }
+    fields[i] = c;
+    while(*c != '\t' && *c != 0){
+      c++;
+    }
+    if(*c == '\t'){
+      *c = 0;
+      c++;
+    }
+  }
+  while(*c == '\t'){
+    c++;
+  }
+  char *end = c + strlen(c);
+  while(end > c && end[-1] == '\t'){
+    end--;
+  }
+  *end = 0;
+
+  *twist = fields[0];
+  *frac = fields[1];
+  *pd = c;
+  return *c != 0;
+}
+
+/* Records read before the pool runs, and records a worker claims at a time */
+#define BATCH_BLOCK 8192
+#define BATCH_CHUNK 32
+/* Workers past one for each chunk of a block would have nothing to claim */
+#define BATCH_MAX_THREADS (BATCH_BLOCK / BATCH_CHUNK)
+/* Results the cache keeps before it stops taking new ones */
+#define BATCH_CACHE_SLOTS (1 << 20)
+/* Size of a new result store; the file is sparse so this is mostly address space */
+#define BATCH_STORE_SLOTS (1 << 22)
+#define BATCH_STORE_DATA (1ULL << 32)
+
+struct batchPool;
+
+/*
+  A worker keeps its own pdCode matrix and scratch arena, both grown to the
+  largest code it has seen, and appends its records to its own shard, and
+  its stats lines to another when they are asked for. The lookup table,
+  result cache and store, when there are, are shared. A traced worker
+  records into its own ring.
+*/
+typedef struct batchWorker {
+  pthread_t thread;
+  int started;          // thread was created and must be joined
+  int id;
+  struct batchPool *pool;
+  tangleInt (*pdCode)[7];
+  int capacity;
+  arena scratch;
+  const lookupTable *table;
+  resultCache *cache;
+  resultStore *store;
+  int format;              // an enum outputFormat
+  FILE *shard;
+  char *shardText;
+  size_t shardLength;
+  long tangles;
+  long mergeAttempts;
+  long mergeAttemptsSaved;
+  long crossingsRemoved;
+  long simplified;         // tangles that lost crossings to simplifyDiagram
+  long tableHits;
+  long cacheLookups;
+  long cacheHits;
+  long storeHits;
+  long storeFull;
+  FILE *statsShard;
+  char *statsText;
+  size_t statsLength;
+  long statsReduced;
+  conwayStats stats;       // summed over the tangles this worker reduced
+  traceRing *trace;
+} batchWorker;
+
+/*
+  One block of input lines, pointing into the reader's buffer. Workers take
+  chunks in turn from next, which keeps every core busy however unevenly the
+  tangle sizes are spread, and note where in their shard each chunk landed so
+  the block can be written in input order.
+*/
+typedef struct batchPool {
+  char *lines[BATCH_BLOCK];
+  int count;
+  long firstLine;          // input line number of lines[0]
+  atomic_int next;
+  int chunkWorker[BATCH_BLOCK / BATCH_CHUNK];
+  long chunkStart[BATCH_BLOCK / BATCH_CHUNK];
+  long chunkEnd[BATCH_BLOCK / BATCH_CHUNK];
+  long chunkStatsStart[BATCH_BLOCK / BATCH_CHUNK];
+  long chunkStatsEnd[BATCH_BLOCK / BATCH_CHUNK];
+} batchPool;
+
+static void batchRecord(batchWorker *worker, char *line, long lineNumber){
+  char *twist, *frac, *pd;
+  tangleResult result;
+
+  if(!splitRecord(line, &twist, &frac, &pd)){
+    return;
+  }
+  DEBUG_PRINTF("Batch record %s\n", frac);
+
+  size_t length = strlen(pd);
+  int capacity = length / 9 + 1;
+  if(capacity > worker->capacity){
+    free(worker->pdCode);
+    worker->pdCode = malloc(capacity * sizeof(*worker->pdCode));
+    worker->capacity = worker->pdCode != NULL ? capacity : 0;
+  }
+  //a code with no room to parse into is reported like one that ran out of scratch
+  if(worker->pdCode == NULL){
+    writePrefix(worker->shard, worker->format, lineNumber, twist, frac);
+    resetResult(&result);
+    result.status = CONWAY_NO_MEMORY;
+    writeResult(worker->shard, worker->format, &result);
+    worker->tangles++;
+    return;
+  }
+  int row;
+  long long parseStart = worker->statsShard != NULL ? statsClock() : 0;
+  int status = parsePD(pd, length, worker->pdCode, worker->capacity, &row);
+  long long parseNanos = worker->statsShard != NULL ? statsClock() - parseStart : 0;
+  writePrefix(worker->shard, worker->format, lineNumber, twist, frac);
+  if(status != PARSE_OK){
+    writeParseError(worker->shard, worker->format, parseErrorString(status));
+    if(worker->statsShard != NULL){
+      fprintf(worker->statsShard, "{\"line\":%ld,\"parseError\":\"%s\"}\n",
+              lineNumber, parseErrorString(status));
+    }
+    worker->tangles++;
+    return;
+  }
+
+  //Small tangles were all reduced ahead of time, into results good for any format
+  if(worker->table != NULL &&
+     lookupPD(worker->table, row, worker->pdCode, &worker->scratch, &result) == 0){
+    writeResult(worker->shard, worker->format, &result);
+    if(worker->statsShard != NULL){
+      fprintf(worker->statsShard, "{\"line\":%ld,\"crossings\":%d,\"cached\":true}\n",
+              lineNumber, row);
+    }
+    worker->tableHits++;
+    worker->tangles++;
+    return;
+  }
+
+  //Isomorphic tangles share one canonical code, so its result can be reused
+  uint64_t key[2];
+  int keyed = 0;
+  if((worker->cache != NULL || worker->store != NULL) &&
+     canonicalPD(row, worker->pdCode, &worker->scratch) == 0){
+    hashPD(row, worker->pdCode, key);
+    //the results of each format are kept apart, CSV under the plain hash
+    key[1] ^= worker->format;
+    keyed = 1;
+    worker->cacheLookups++;
+    const char *text = NULL;
+    size_t textLength;
+    if(worker->cache != NULL){
+      text = cacheLookup(worker->cache, key, &textLength);
+    }
+    if(text != NULL){
+      worker->cacheHits++;
+    } else if(worker->store != NULL && (text = storeLookup(worker->store, key, &textLength)) != NULL){
+      worker->storeHits++;
+      if(worker->cache != NULL){
+        cacheInsert(worker->cache, key, text, textLength);
+      }
+    }
+    if(text != NULL){
+      fwrite(text, 1, textLength, worker->shard);
+      if(worker->statsShard != NULL){
+        fprintf(worker->statsShard, "{\"line\":%ld,\"crossings\":%d,\"cached\":true}\n",
+                lineNumber, row);
+      }
+      worker->tangles++;
+      return;
+    }
+  }
+
+  long start = ftell(worker->shard);
+  if(worker->trace != NULL){
+    worker->trace->label = lineNumber;
+  }
+  pdToConwayArena(row, worker->pdCode, &result, &worker->scratch);
+  writeResult(worker->shard, worker->format, &result);
+  if(keyed){
+    fflush(worker->shard);
+    if(worker->cache != NULL){
+      cacheInsert(worker->cache, key, worker->shardText + start, worker->shardLength - start);
+    }
+    if(worker->store != NULL &&
+       storeInsert(worker->store, key, worker->shardText + start, worker->shardLength - start) != 0){
+      worker->storeFull++;
+    }
+  }
+  worker->tangles++;
+  worker->mergeAttempts += result.mergeAttempts;
+  worker->mergeAttemptsSaved += result.mergeAttemptsSaved;
+  worker->crossingsRemoved += result.crossingsRemoved;
+  worker->simplified += result.crossingsRemoved > 0;
+#ifdef CONWAY_STATS
+  if(worker->statsShard != NULL){
+    result.stats.stageNanos[STAGE_PARSE] = parseNanos;
+    fprintf(worker->statsShard, "{\"line\":%ld,\"crossings\":%d,\"status\":%d,",
+            lineNumber, row, result.status);
+    statsJSON(worker->statsShard, &result.stats);
+    fprintf(worker->statsShard, "}\n");
+    statsAdd(&worker->stats, &result.stats);
+    worker->statsReduced++;
+  }
+#else
+  (void)parseNanos;
+#endif
+}
+
+static void *batchWork(void *arg){
+  batchWorker *worker = arg;
+  batchPool *pool = worker->pool;
+  int chunk;
+
+  TRACE_ATTACH(worker->trace);
+  while((chunk = atomic_fetch_add(&pool->next, 1)) * BATCH_CHUNK < pool->count){
+    int end = (chunk + 1) * BATCH_CHUNK;
+    if(end > pool->count){
+      end = pool->count;
+    }
+    pool->chunkWorker[chunk] = worker->id;
+    pool->chunkStart[chunk] = ftell(worker->shard);
+    if(worker->statsShard != NULL){
+      pool->chunkStatsStart[chunk] = ftell(worker->statsShard);
+    }
+    for(int i = chunk * BATCH_CHUNK; i < end; i++){
+      batchRecord(worker, pool->lines[i], pool->firstLine + i);
+    }
+    pool->chunkEnd[chunk] = ftell(worker->shard);
+    if(worker->statsShard != NULL){
+      pool->chunkStatsEnd[chunk] = ftell(worker->statsShard);
+    }
+  }
+  TRACE_ATTACH(NULL);
+  return NULL;
+}
+
+/*
+  Hands up to BATCH_BLOCK lines of the reader's buffer to the pool. The
+  buffer is only refilled when the pool starts empty, as the lines of a
+  block point into it until the block is written out. Returns the number of
+  lines, or -1 on a read error.
+*/
+static int readBlock(batchPool *pool, inputReader *reader){
+  size_t length;
+
+  pool->firstLine += pool->count;
+  pool->count = 0;
+  while(pool->count < BATCH_BLOCK){
+    char *line = readerLine(reader, &length);
+    if(line == NULL){
+      if(pool->count > 0){
+        break;
+      }
+      int filled = readerFill(reader);
+      if(filled <= 0){
+        return filled;
+      }
+      continue;
+    }
+    pool->lines[pool->count++] = line;
+  }
+  return pool->count;
+}
+
+/*
+  Reads tab separated records laid out like pdCodes.txt and writes one record
+  per record with a PD code in format, an enum outputFormat. CSV rows match
+  the ones getTangles.sh used to build by running the program once per line.
+  The input is read in large blocks and parsed where it lies, so memory does
+  not grow with its size. The records are reduced by threads workers, the
+  rows still come out in input order, and the throughput is reported on
+  stderr once the input is exhausted. threads is capped at
+  BATCH_MAX_THREADS.
+
+  With cacheResults set each tangle is reduced in its canonical form, and a
+  tangle isomorphic to one already reduced reuses its result. A storePath
+  does the same with results kept on disk across runs, creating the store
+  if needed. A tablePath names a table tools/buildTable wrote, where every
+  tangle small enough is looked up before anything else, with the result of
+  its canonical form. Where the reducer's answer depends on how the
+  crossings are listed, these can differ from reducing the record as given;
+  see src/TODO.txt.
+
+  Given statsOut, which needs a build with CONWAY_STATS, a JSON line of
+  stage times and counters is written there for every record, in input
+  order, and a last line sums them over the batch.
+
+  Given traceOut, which needs a build with CONWAY_TRACE, each worker traces
+  into a ring labelled with the input line of the tangle it is on, and the
+  rings are written there at the end for tools/traceDecode.
+*/
+int runBatch(FILE *in, int threads, int format, const char *tablePath, int cacheResults,
+             const char *storePath, FILE *statsOut, FILE *traceOut){
+  if(threads > BATCH_MAX_THREADS){
+    threads = BATCH_MAX_THREADS;
+  }
+  batchPool *pool = calloc(1, sizeof(batchPool));
+  batchWorker *workers = calloc(threads, sizeof(batchWorker));
+  traceRing *rings = traceOut != NULL ? calloc(threads, sizeof(traceRing)) : NULL;
+  struct timespec begin, end;
+  long tangles = 0;
+  long attempts = 0;
+  long saved = 0;
+  long crossingsRemoved = 0;
+  long simplified = 0;
+  long tableHits = 0;
+  long lookups = 0;
+  long hits = 0;
+  long storeHits = 0;
+  long storeFull = 0;
+  long reduced = 0;
+  conwayStats stats;
+  lookupTable table;
+  resultCache cache;
+  resultStore store;
+  inputReader reader;
+  int createFailed = 0;
+
+  if(readerInit(&reader, fileno(in)) != 0 || pool == NULL || workers == NULL ||
+     (traceOut != NULL && rings == NULL)){
+    perror("runBatch");
+    free(pool);
+    free(workers);
+    free(rings);
+    readerFree(&reader);
+    return 1;
+  }
+  if(tablePath != NULL && lookupOpen(&table, tablePath) != 0){
+    lookupPerror(tablePath);
+    free(pool);
+    free(workers);
+    free(rings);
+    readerFree(&reader);
+    return 1;
+  }
+  if(cacheResults && cacheInit(&cache, BATCH_CACHE_SLOTS) != 0){
+    perror("runBatch");
+    if(tablePath != NULL){
+      lookupClose(&table);
+    }
+    free(pool);
+    free(workers);
+    free(rings);
+    readerFree(&reader);
+    return 1;
+  }
+  if(storePath != NULL && storeOpen(&store, storePath, BATCH_STORE_SLOTS, BATCH_STORE_DATA) != 0){
+    storePerror(storePath);
+    if(tablePath != NULL){
+      lookupClose(&table);
+    }
+    if(cacheResults){
+      cacheFree(&cache);
+    }
+    free(pool);
+    free(workers);
+    free(rings);
+    readerFree(&reader);
+    return 1;
+  }
+  for(int w = 0; traceOut != NULL && w < threads; w++){
+    if(traceInit(&rings[w]) != 0){
+      perror("traceInit");
+      for(int i = 0; i < w; i++){
+        traceFree(&rings[i]);
+      }
+      if(tablePath != NULL){
+        lookupClose(&table);
+      }
+      if(cacheResults){
+        cacheFree(&cache);
+      }
+      if(storePath != NULL){
+        storeClose(&store);
+      }
+      free(pool);
+      free(workers);
+      free(rings);
+      readerFree(&reader);
+      return 1;
+    }
+  }
+  for(int w = 0; w < threads; w++){
+    workers[w].id = w;
+    workers[w].pool = pool;
+    workers[w].format = format;
+    workers[w].pdCode = NULL;
+    workers[w].capacity = 0;
+    arenaInit(&workers[w].scratch);
+    workers[w].table = tablePath != NULL ? &table : NULL;
+    workers[w].cache = cacheResults ? &cache : NULL;
+    workers[w].store = storePath != NULL ? &store : NULL;
+    workers[w].tangles = 0;
+    workers[w].mergeAttempts = 0;
+    workers[w].mergeAttemptsSaved = 0;
+    workers[w].crossingsRemoved = 0;
+    workers[w].simplified = 0;
+    workers[w].tableHits = 0;
+    workers[w].cacheLookups = 0;
+    workers[w].cacheHits = 0;
+    workers[w].storeHits = 0;
+    workers[w].storeFull = 0;
+    workers[w].statsShard = NULL;
+    workers[w].statsReduced = 0;
+    statsReset(&workers[w].stats);
+    workers[w].trace = traceOut != NULL ? &rings[w] : NULL;
+  }
+  statsReset(&stats);
+  //line numbers start at 1
+  pool->firstLine = 1;
+
+  writeHeader(stdout, format);
+  clock_gettime(CLOCK_MONOTONIC, &begin);
+  int lines;
+  while((lines = readBlock(pool, &reader)) > 0){
+    atomic_store(&pool->next, 0);
+    for(int w = 0; w < threads; w++){
+      workers[w].shard = open_memstream(&workers[w].shardText, &workers[w].shardLength);
+      if(statsOut != NULL){
+        workers[w].statsShard = open_memstream(&workers[w].statsText, &workers[w].statsLength);
+      }
+    }
+
+    //A single worker runs on the calling thread
+    if(threads == 1){
+      batchWork(&workers[0]);
+    } else {
+      //workers claim chunks until none are left, so the ones that started finish the block
+      int started = 0;
+      for(int w = 0; w < threads; w++){
+        int error = pthread_create(&workers[w].thread, NULL, batchWork, &workers[w]);
+        workers[w].started = error == 0;
+        started += workers[w].started;
+        if(error != 0 && !createFailed){
+          fprintf(stderr, "pthread_create: %s\n", strerror(error));
+          createFailed = 1;
+        }
+      }
+      for(int w = 0; w < threads; w++){
+        if(workers[w].started){
+          pthread_join(workers[w].thread, NULL);
+        }
+      }
+      if(started == 0){
+        batchWork(&workers[0]);
+      }
+    }
+
+    for(int w = 0; w < threads; w++){
+      fclose(workers[w].shard);
+      if(statsOut != NULL){
+        fclose(workers[w].statsShard);
+      }
+    }
+    int chunks = (pool->count + BATCH_CHUNK - 1) / BATCH_CHUNK;
+    for(int chunk = 0; chunk < chunks; chunk++){
+      batchWorker *worker = &workers[pool->chunkWorker[chunk]];
+      fwrite(worker->shardText + pool->chunkStart[chunk], 1,
+             pool->chunkEnd[chunk] - pool->chunkStart[chunk], stdout);
+      if(statsOut != NULL){
+        fwrite(worker->statsText + pool->chunkStatsStart[chunk], 1,
+               pool->chunkStatsEnd[chunk] - pool->chunkStatsStart[chunk], statsOut);
+      }
+    }
+    for(int w = 0; w < threads; w++){
+      free(workers[w].shardText);
+      if(statsOut != NULL){
+        free(workers[w].statsText);
+      }
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  if(lines < 0){
+    perror("read");
+  }
+
+  for(int w = 0; w < threads; w++){
+    tangles += workers[w].tangles;
+    attempts += workers[w].mergeAttempts;
+    saved += workers[w].mergeAttemptsSaved;
+    crossingsRemoved += workers[w].crossingsRemoved;
+    simplified += workers[w].simplified;
+    tableHits += workers[w].tableHits;
+    lookups += workers[w].cacheLookups;
+    hits += workers[w].cacheHits;
+    storeHits += workers[w].storeHits;
+    storeFull += workers[w].storeFull;
+    reduced += workers[w].statsReduced;
+    statsAdd(&stats, &workers[w].stats);
+    free(workers[w].pdCode);
+    arenaFree(&workers[w].scratch);
+  }
+  if(traceOut != NULL){
+    if(traceWrite(traceOut, rings, threads) != 0){
+      perror("traceWrite");
+    }
+    for(int w = 0; w < threads; w++){
+      traceFree(&rings[w]);
+    }
+  }
+  free(pool);
+  free(workers);
+  free(rings);
+  readerFree(&reader);
+  if(tablePath != NULL){
+    lookupClose(&table);
+  }
+  if(cacheResults){
+    cacheFree(&cache);
+  }
+  if(storePath != NULL){
+    storeClose(&store);
+  }
+
+  double seconds = (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9;
+  if(statsOut != NULL){
+    fprintf(statsOut, "{\"batch\":{\"tangles\":%ld,\"reduced\":%ld,\"cached\":%ld,"
+            "\"threads\":%d,\"seconds\":%.6f,", tangles, reduced, tableHits + hits + storeHits,
+            threads, seconds);
+    statsJSON(statsOut, &stats);
+    fprintf(statsOut, "}}\n");
+  }
+  fprintf(stderr, "%ld tangles in %.3f s on %d threads, %.0f tangles/sec\n",
+          tangles, seconds, threads, seconds > 0 ? tangles / seconds : 0.0);
+  fprintf(stderr, "%ld merge attempts, %ld saved over full sweeps (%.1f%%)\n",
+          attempts, saved, attempts + saved > 0 ? 100.0 * saved / (attempts + saved) : 0.0);
+  fprintf(stderr, "%ld crossings removed by Reidemeister I/II moves from %ld tangles\n",
+          crossingsRemoved, simplified);
+  if(tablePath != NULL){
+    fprintf(stderr, "%ld of %ld tangles found in %s (%.1f%%)\n",
+            tableHits, tangles, tablePath, tangles > 0 ? 100.0 * tableHits / tangles : 0.0);
+  }
+  if(cacheResults){
+    fprintf(stderr, "%ld cache hits in %ld lookups (%.1f%%)\n",
+            hits, lookups, lookups > 0 ? 100.0 * hits / lookups : 0.0);
+  }
+  if(storePath != NULL){
+    fprintf(stderr, "%ld store hits in %ld lookups (%.1f%%)\n",
+            storeHits, lookups, lookups > 0 ? 100.0 * storeHits / lookups : 0.0);
+    if(storeFull > 0){
+      fprintf(stderr, "%s is full, %ld results were not kept; compact it into a larger store\n",
+              storePath, storeFull);
+    }
+  }
+  return lines < 0;
+}
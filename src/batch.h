@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdio.h>
+
+int runBatch(FILE *in, int threads, int format, const char *tablePath, int cacheResults,
+             const char *storePath, FILE *statsOut, FILE *traceOut);
@@ -0,0 +1,356 @@
+#include "bigint.h"
+#include <stdio.h>
+#include <string.h>
+
+_Thread_local bigFractions *activeBig;
+
+static const bigInt zero = {0, 0, NULL};
+
+/* Starts a pool taking its limbs from scratch and attaches it to this thread */
+void bigAttach(bigFractions *pool, arena *scratch) {
+  pool->scratch = scratch;
+  pool->values = NULL;
+  pool->count = 0;
+  pool->capacity = 0;
+  pool->failed = 0;
+  activeBig = pool;
+}
+
+void bigDetach(void) {
+  activeBig = NULL;
+}
+
+/* A value with room for limbs limbs; zero, with the pool failed, when scratch ran out */
+static bigInt bigNew(int limbs) {
+  bigInt v = zero;
+  v.limbs = arenaAlloc(activeBig->scratch, limbs * sizeof(uint32_t));
+  if (v.limbs == NULL) {
+    activeBig->failed = 1;
+  }
+  return v;
+}
+
+static void trim(bigInt *v) {
+  while (v->length > 0 && v->limbs[v->length - 1] == 0) {
+    v->length--;
+  }
+  if (v->length == 0) {
+    v->sign = 0;
+  }
+}
+
+/* The value a tangleInt stands for; a plain one is spelled out in small, which must outlive it */
+static bigInt bigValue(tangleInt value, uint32_t small[2]) {
+  bigInt v = {value < 0 ? -1 : 1, 2, small};
+
+  if (fractionIsBig(value)) {
+    v = activeBig->values[llabs(value) - FRACTION_BIG];
+    v.sign = value < 0 ? -1 : 1;
+    return v;
+  }
+  unsigned long long magnitude = llabs(value);
+  small[0] = (uint32_t)magnitude;
+  small[1] = (uint32_t)(magnitude >> 32);
+  trim(&v);
+  return v;
+}
+
+/* The tangleInt for v: v itself below FRACTION_BIG, else a handle to v kept in the pool */
+static tangleInt bigHandle(bigInt v) {
+  bigFractions *pool = activeBig;
+
+  if (v.length <= 2) {
+    unsigned long long magnitude = v.length > 0 ? v.limbs[0] : 0;
+    if (v.length == 2) {
+      magnitude |= (unsigned long long)v.limbs[1] << 32;
+    }
+    if (magnitude < (unsigned long long)FRACTION_BIG) {
+      return v.sign < 0 ? -(tangleInt)magnitude : (tangleInt)magnitude;
+    }
+  }
+  if (pool->count == pool->capacity) {
+    int capacity = 2 * pool->capacity + 16;
+    bigInt *values = arenaAlloc(pool->scratch, capacity * sizeof(bigInt));
+    if (values == NULL) {
+      pool->failed = 1;
+      return 0;
+    }
+    if (pool->count > 0) {
+      memcpy(values, pool->values, pool->count * sizeof(bigInt));
+    }
+    pool->values = values;
+    pool->capacity = capacity;
+  }
+  int sign = v.sign;
+  v.sign = 1;
+  pool->values[pool->count] = v;
+  tangleInt handle = FRACTION_BIG + pool->count++;
+  return sign < 0 ? -handle : handle;
+}
+
+static int magnitudeCompare(bigInt a, bigInt b) {
+  if (a.length != b.length) {
+    return a.length < b.length ? -1 : 1;
+  }
+  for (int i = a.length - 1; i >= 0; i--) {
+    if (a.limbs[i] != b.limbs[i]) {
+      return a.limbs[i] < b.limbs[i] ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+/* |a| + |b|, given sign */
+static bigInt magnitudeAdd(bigInt a, bigInt b, int sign) {
+  if (a.length < b.length) {
+    bigInt t = a;
+    a = b;
+    b = t;
+  }
+  bigInt r = bigNew(a.length + 1);
+  if (r.limbs == NULL) {
+    return zero;
+  }
+  uint64_t carry = 0;
+  for (int i = 0; i < a.length; i++) {
+    carry += (uint64_t)a.limbs[i] + (i < b.length ? b.limbs[i] : 0);
+    r.limbs[i] = (uint32_t)carry;
+    carry >>= 32;
+  }
+  r.limbs[a.length] = (uint32_t)carry;
+  r.length = a.length + 1;
+  r.sign = sign;
+  trim(&r);
+  return r;
+}
+
+/* Takes |b| from a->limbs in place, for |a| >= |b| */
+static void subtractInPlace(bigInt *a, bigInt b) {
+  uint32_t borrow = 0;
+  for (int i = 0; i < a->length; i++) {
+    uint64_t take = (uint64_t)(i < b.length ? b.limbs[i] : 0) + borrow;
+    borrow = a->limbs[i] < take;
+    a->limbs[i] = (uint32_t)(a->limbs[i] - take);
+  }
+  trim(a);
+}
+
+/* |a| - |b|, given sign, for |a| >= |b| */
+static bigInt magnitudeSubtract(bigInt a, bigInt b, int sign) {
+  if (a.length == 0) {
+    return zero;
+  }
+  bigInt r = bigNew(a.length);
+  if (r.limbs == NULL) {
+    return zero;
+  }
+  memcpy(r.limbs, a.limbs, a.length * sizeof(uint32_t));
+  r.length = a.length;
+  r.sign = sign;
+  subtractInPlace(&r, b);
+  return r;
+}
+
+static bigInt bigAdd(bigInt a, bigInt b) {
+  if (a.sign == 0) {
+    return b;
+  }
+  if (b.sign == 0) {
+    return a;
+  }
+  if (a.sign == b.sign) {
+    return magnitudeAdd(a, b, a.sign);
+  }
+  if (magnitudeCompare(a, b) >= 0) {
+    return magnitudeSubtract(a, b, a.sign);
+  }
+  return magnitudeSubtract(b, a, b.sign);
+}
+
+static bigInt bigMul(bigInt a, bigInt b) {
+  if (a.sign == 0 || b.sign == 0) {
+    return zero;
+  }
+  bigInt r = bigNew(a.length + b.length);
+  if (r.limbs == NULL) {
+    return zero;
+  }
+  memset(r.limbs, 0, (a.length + b.length) * sizeof(uint32_t));
+  for (int i = 0; i < a.length; i++) {
+    uint64_t carry = 0;
+    for (int j = 0; j < b.length; j++) {
+      carry += (uint64_t)a.limbs[i] * b.limbs[j] + r.limbs[i + j];
+      r.limbs[i + j] = (uint32_t)carry;
+      carry >>= 32;
+    }
+    r.limbs[i + b.length] = (uint32_t)carry;
+  }
+  r.length = a.length + b.length;
+  r.sign = a.sign * b.sign;
+  trim(&r);
+  return r;
+}
+
+static int bitLength(bigInt a) {
+  return a.length == 0 ? 0 : 32 * a.length - __builtin_clz(a.limbs[a.length - 1]);
+}
+
+/*
+  a / b rounded toward zero into *quotient and what is left, with the sign
+  of a, into *remainder, as C divides. Shifts b up to a and takes it away
+  bit by bit, so the cost goes with the bits of the quotient, which stay
+  few in the continued fractions this is used for.
+*/
+static void bigDivide(bigInt a, bigInt b, bigInt *quotient, bigInt *remainder) {
+  *quotient = zero;
+  *remainder = a;
+  if (b.sign == 0 || magnitudeCompare(a, b) < 0) {
+    return;
+  }
+  int shift = bitLength(a) - bitLength(b);
+  int words = shift / 32;
+  bigInt q = bigNew(words + 1);
+  bigInt r = bigNew(a.length);
+  bigInt d = bigNew(a.length + 1);
+  if (q.limbs == NULL || r.limbs == NULL || d.limbs == NULL) {
+    *remainder = zero;
+    return;
+  }
+  memset(q.limbs, 0, (words + 1) * sizeof(uint32_t));
+  q.length = words + 1;
+  q.sign = a.sign * b.sign;
+  memcpy(r.limbs, a.limbs, a.length * sizeof(uint32_t));
+  r.length = a.length;
+  r.sign = a.sign;
+  //d = |b| shifted up to the top bit of a
+  memset(d.limbs, 0, (a.length + 1) * sizeof(uint32_t));
+  for (int i = 0; i < b.length; i++) {
+    uint64_t shifted = (uint64_t)b.limbs[i] << (shift % 32);
+    d.limbs[i + words] |= (uint32_t)shifted;
+    d.limbs[i + words + 1] |= (uint32_t)(shifted >> 32);
+  }
+  d.length = a.length + 1;
+  d.sign = 1;
+  trim(&d);
+  for (int s = shift; s >= 0; s--) {
+    if (magnitudeCompare(r, d) >= 0) {
+      subtractInPlace(&r, d);
+      q.limbs[s / 32] |= (uint32_t)1 << (s % 32);
+    }
+    for (int i = 0; i < d.length; i++) {
+      d.limbs[i] = d.limbs[i] >> 1 | (i + 1 < d.length ? d.limbs[i + 1] << 31 : 0);
+    }
+    trim(&d);
+  }
+  trim(&q);
+  *quotient = q;
+  *remainder = r;
+}
+
+tangleInt bigFractionAdd(tangleInt a, tangleInt b) {
+  uint32_t x[2], y[2];
+  return bigHandle(bigAdd(bigValue(a, x), bigValue(b, y)));
+}
+
+tangleInt bigFractionMul(tangleInt a, tangleInt b) {
+  uint32_t x[2], y[2];
+  return bigHandle(bigMul(bigValue(a, x), bigValue(b, y)));
+}
+
+tangleInt bigFractionDiv(tangleInt a, tangleInt b) {
+  uint32_t x[2], y[2];
+  bigInt quotient, remainder;
+  bigDivide(bigValue(a, x), bigValue(b, y), &quotient, &remainder);
+  return bigHandle(quotient);
+}
+
+tangleInt bigFractionMod(tangleInt a, tangleInt b) {
+  uint32_t x[2], y[2];
+  bigInt quotient, remainder;
+  bigDivide(bigValue(a, x), bigValue(b, y), &quotient, &remainder);
+  return bigHandle(remainder);
+}
+
+int bigFractionAbsLess(tangleInt a, tangleInt b) {
+  uint32_t x[2], y[2];
+  return magnitudeCompare(bigValue(a, x), bigValue(b, y)) < 0;
+}
+
+/* ainversemodb past tangleInt: extended Euclid on b and a, keeping the coefficient of b */
+int bigInverse(tangleInt b, tangleInt a, tangleInt *inverse) {
+  uint32_t x[2], y[2], one[2], m[2];
+
+  if (a == 1 || a == -1) {
+    *inverse = a;
+    return 0;
+  }
+  if (a == 0) {
+    return -1;
+  }
+  bigInt oldR = bigValue(b, x), r = bigValue(a, y);
+  bigInt oldX = bigValue(1, one), X = zero;
+  while (r.sign != 0) {
+    bigInt q, rest;
+    bigDivide(oldR, r, &q, &rest);
+    oldR = r;
+    r = rest;
+    bigInt next = bigMul(q, X);
+    next.sign = -next.sign;
+    next = bigAdd(oldX, next);
+    oldX = X;
+    X = next;
+  }
+  if (oldR.sign < 0) {
+    oldR.sign = 1;
+    oldX.sign = -oldX.sign;
+  }
+  if (oldR.length != 1 || oldR.limbs[0] != 1) {
+    return -1;
+  }
+  bigInt modulus = bigValue(a, m), q, rest;
+  modulus.sign = 1;
+  bigDivide(oldX, modulus, &q, &rest);
+  if (rest.sign < 0) {
+    rest = bigAdd(rest, modulus);
+  }
+  *inverse = bigHandle(rest);
+  return 0;
+}
+
+/* Writes value in decimal, returning its length, or -1 when it does not fit in size */
+int bigText(tangleInt value, char *buf, int size) {
+  uint32_t small[2];
+  int n;
+
+  if (!fractionIsBig(value)) {
+    n = snprintf(buf, size, "%lld", value);
+    return n < size ? n : -1;
+  }
+  bigInt v = bigValue(value, small);
+  uint32_t *limbs = arenaAlloc(activeBig->scratch, v.length * sizeof(uint32_t));
+  uint32_t *chunks = arenaAlloc(activeBig->scratch, (2 * v.length + 2) * sizeof(uint32_t));
+  if (limbs == NULL || chunks == NULL) {
+    activeBig->failed = 1;
+    return -1;
+  }
+  memcpy(limbs, v.limbs, v.length * sizeof(uint32_t));
+  //nine digits at a time, the lowest first
+  int length = v.length, count = 0;
+  while (length > 0) {
+    uint64_t rest = 0;
+    for (int i = length - 1; i >= 0; i--) {
+      uint64_t current = rest << 32 | limbs[i];
+      limbs[i] = (uint32_t)(current / 1000000000);
+      rest = current % 1000000000;
+    }
+    chunks[count++] = (uint32_t)rest;
+    while (length > 0 && limbs[length - 1] == 0) {
+      length--;
+    }
+  }
+  n = snprintf(buf, size, "%s%u", v.sign < 0 ? "-" : "", chunks[count - 1]);
+  for (int i = count - 2; i >= 0 && n < size; i--) {
+    n += snprintf(buf + n, size - n, "%09u", chunks[i]);
+  }
+  return n < size ? n : -1;
+}
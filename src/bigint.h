@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+#include "arena.h"
+#include "fraction.h"
+
+/*
+  A signed integer of any size, in 32-bit limbs from the least significant,
+  with no leading zero limb
+*/
+typedef struct bigInt {
+  int sign;         // -1, 0 or 1; zero has no limbs
+  int length;
+  uint32_t *limbs;
+} bigInt;
+
+/*
+  The fractions of one reduction redone with arbitrary precision. Every
+  value that reaches FRACTION_BIG in magnitude is kept here, and the
+  tangleInt standing for it is a handle, FRACTION_BIG + i with the sign of
+  the value for values[i]. Limbs come from the reduction's arena, so they go
+  with its next reset.
+*/
+struct bigFractions {
+  arena *scratch;
+  bigInt *values;   // magnitudes, the sign is the handle's
+  int count;
+  int capacity;
+  int failed;       // scratch ran out, so some value is wrong
+};
+
+void bigAttach(bigFractions *pool, arena *scratch);
+void bigDetach(void);
+int bigText(tangleInt value, char *buf, int size);
+int bigInverse(tangleInt b, tangleInt a, tangleInt *inverse);
@@ -0,0 +1,72 @@
+#include "cache.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Returns 0, or -1 when the slots could not be allocated */
+int cacheInit(resultCache *cache, size_t size) {
+  size_t slots = 1;
+  while (slots < size) {
+    slots *= 2;
+  }
+  cache->slots = calloc(slots, sizeof(cacheEntry));
+  if (cache->slots == NULL) {
+    return -1;
+  }
+  cache->size = slots;
+  cache->entries = 0;
+  pthread_mutex_init(&cache->lock, NULL);
+  return 0;
+}
+
+/* Slot holding key, or the empty slot where it would go */
+static cacheEntry *cacheSlot(resultCache *cache, const uint64_t key[2]) {
+  size_t mask = cache->size - 1;
+  size_t i = key[0] & mask;
+  while (cache->slots[i].text != NULL &&
+         (cache->slots[i].key[0] != key[0] || cache->slots[i].key[1] != key[1])) {
+    i = (i + 1) & mask;
+  }
+  return &cache->slots[i];
+}
+
+/* Text stored for key and its length, or NULL */
+const char *cacheLookup(resultCache *cache, const uint64_t key[2], size_t *length) {
+  pthread_mutex_lock(&cache->lock);
+  cacheEntry *slot = cacheSlot(cache, key);
+  const char *text = slot->text;
+  *length = slot->length;
+  pthread_mutex_unlock(&cache->lock);
+  return text;
+}
+
+/*
+  Stores a copy of text[0..length) for key unless it is already there. Once
+  the table is three quarters full further results are simply not kept.
+*/
+void cacheInsert(resultCache *cache, const uint64_t key[2], const char *text, size_t length) {
+  pthread_mutex_lock(&cache->lock);
+  if (4 * (cache->entries + 1) <= 3 * cache->size) {
+    cacheEntry *slot = cacheSlot(cache, key);
+    if (slot->text == NULL) {
+      char *copy = malloc(length + 1);
+      if (copy != NULL) {
+        memcpy(copy, text, length);
+        copy[length] = 0;
+        slot->key[0] = key[0];
+        slot->key[1] = key[1];
+        slot->text = copy;
+        slot->length = length;
+        cache->entries++;
+      }
+    }
+  }
+  pthread_mutex_unlock(&cache->lock);
+}
+
+void cacheFree(resultCache *cache) {
+  for (size_t i = 0; i < cache->size; i++) {
+    free(cache->slots[i].text);
+  }
+  free(cache->slots);
+  pthread_mutex_destroy(&cache->lock);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  Results already printed for tangles, keyed on the hash of their canonical
+  PD code and shared by every batch worker. Entries are never replaced or
+  removed before cacheFree, so text found by cacheLookup stays valid.
+*/
+typedef struct cacheEntry {
+  uint64_t key[2];
+  char *text;   // NULL for an empty slot
+  size_t length;
+} cacheEntry;
+
+typedef struct resultCache {
+  pthread_mutex_t lock;
+  cacheEntry *slots;
+  size_t size;     // a power of two
+  size_t entries;
+} resultCache;
+
+int cacheInit(resultCache *cache, size_t size);
+const char *cacheLookup(resultCache *cache, const uint64_t key[2], size_t *length);
+void cacheInsert(resultCache *cache, const uint64_t key[2], const char *text, size_t length);
+void cacheFree(resultCache *cache);
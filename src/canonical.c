@@ -0,0 +1,166 @@
+#include "canonical.h"
+
+/*
+  Canonical form of a 4-ended PD code. The four ends (labels seen once) keep
+  their labels, since which end is labelled first fixes how the tangle sits.
+  Everything else is renumbered by walking the strands: first from each end
+  in label order, then around any closed loop from the first crossing, in the
+  new order, that still has an unlabelled arc. Crossings are numbered as the
+  walks first reach them and the inner arcs take the remaining labels in the
+  order they are walked. The result depends only on the diagram and its
+  ends, not on how the arcs were labelled or the crossings listed.
+*/
+
+typedef struct canonicalWalk {
+  tangleInt (*pdCode)[7];
+  int *seen;       // seen[2*label + k] is the k-th crossing*4 + clock holding label
+  int *count;      // times each label appears
+  int *newLabel;   // -1 until walked
+  int *newIndex;   // new row of each crossing, -1 until reached
+  int *order;      // old crossing at each new row
+  int reached;
+  int nextInner;   // smallest label not yet checked for handing to an inner arc
+} canonicalWalk;
+
+size_t canonicalArenaSize(int rows) {
+  int labels = 2 * rows + 2;
+  return (size_t)(2 * labels + labels + labels + rows + rows) * sizeof(int) + 5 * ARENA_ALIGN;
+}
+
+static void reach(canonicalWalk *w, int crossing) {
+  if (w->newIndex[crossing] < 0) {
+    w->newIndex[crossing] = w->reached;
+    w->order[w->reached++] = crossing;
+  }
+}
+
+/* Next label for an inner arc: the labels no end uses, in increasing order */
+static int innerLabel(canonicalWalk *w) {
+  while (w->count[w->nextInner] == 1) {
+    w->nextInner++;
+  }
+  return w->nextInner++;
+}
+
+/* Labels the strand leaving crossing at clock until it closes or reaches an end */
+static void walkFrom(canonicalWalk *w, int crossing, int clock) {
+  while (1) {
+    int label = w->pdCode[crossing][clock];
+    if (w->newLabel[label] >= 0) {
+      return;
+    }
+    if (w->count[label] == 1) {
+      w->newLabel[label] = label;
+      return;
+    }
+    w->newLabel[label] = innerLabel(w);
+    int here = 4 * crossing + clock;
+    int there = w->seen[2 * label] == here ? w->seen[2 * label + 1] : w->seen[2 * label];
+    crossing = there / 4;
+    reach(w, crossing);
+    clock = (there % 4 + 2) % 4;
+  }
+}
+
+/*
+  Rewrites pdCode, a code parsePD accepted, in canonical form, taking its
+  scratch from the arena. Returns 0, or -1 when part of the diagram cannot be
+  reached from its ends or scratch ran out, in which case pdCode is left as
+  it was.
+*/
+int canonicalPD(int rows, tangleInt pdCode[][7], arena *scratch) {
+  int labels = 2 * rows + 2;
+  canonicalWalk w;
+
+  if (arenaReset(scratch, canonicalArenaSize(rows)) != 0) {
+    return -1;
+  }
+  w.pdCode = pdCode;
+  w.seen = arenaAlloc(scratch, 2 * labels * sizeof(int));
+  w.count = arenaAlloc(scratch, labels * sizeof(int));
+  w.newLabel = arenaAlloc(scratch, labels * sizeof(int));
+  w.newIndex = arenaAlloc(scratch, rows * sizeof(int));
+  w.order = arenaAlloc(scratch, rows * sizeof(int));
+  if (w.seen == NULL || w.count == NULL || w.newLabel == NULL || w.newIndex == NULL ||
+      w.order == NULL) {
+    return -1;
+  }
+  w.reached = 0;
+  w.nextInner = 0;
+
+  for (int label = 0; label < labels; label++) {
+    w.count[label] = 0;
+    w.newLabel[label] = -1;
+  }
+  for (int i = 0; i < rows; i++) {
+    w.newIndex[i] = -1;
+    for (int j = 0; j < 4; j++) {
+      int label = pdCode[i][j];
+      w.seen[2 * label + w.count[label]++] = 4 * i + j;
+    }
+  }
+
+  for (int label = 0; label < labels; label++) {
+    if (w.count[label] == 1 && w.newLabel[label] < 0) {
+      int crossing = w.seen[2 * label] / 4;
+      int clock = w.seen[2 * label] % 4;
+      w.newLabel[label] = label;
+      reach(&w, crossing);
+      walkFrom(&w, crossing, (clock + 2) % 4);
+    }
+  }
+  for (int i = 0; i < w.reached; i++) {
+    for (int j = 0; j < 4; j++) {
+      walkFrom(&w, w.order[i], j);
+    }
+  }
+  if (w.reached < rows) {
+    return -1;
+  }
+
+  //relabel in place, then move each row to its new index a cycle at a time
+  for (int i = 0; i < rows; i++) {
+    for (int j = 0; j < 4; j++) {
+      pdCode[i][j] = w.newLabel[pdCode[i][j]];
+    }
+  }
+  for (int i = 0; i < rows; i++) {
+    while (w.newIndex[i] != i) {
+      int to = w.newIndex[i];
+      for (int j = 0; j < 7; j++) {
+        tangleInt temp = pdCode[i][j];
+        pdCode[i][j] = pdCode[to][j];
+        pdCode[to][j] = temp;
+      }
+      w.newIndex[i] = w.newIndex[to];
+      w.newIndex[to] = to;
+    }
+  }
+  return 0;
+}
+
+/* splitmix64 finaliser */
+static uint64_t mix(uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+/* 128-bit hash of the crossings of pdCode, as two independent 64-bit halves */
+void hashPD(int rows, tangleInt pdCode[][7], uint64_t hash[2]) {
+  uint64_t a = 0x9e3779b97f4a7c15ULL ^ (uint64_t)rows;
+  uint64_t b = 0x6a09e667f3bcc909ULL ^ (uint64_t)rows;
+
+  for (int i = 0; i < rows; i++) {
+    for (int j = 0; j < 4; j += 2) {
+      uint64_t word = (uint32_t)pdCode[i][j] | (uint64_t)(uint32_t)pdCode[i][j + 1] << 32;
+      a = mix(a ^ word);
+      b = mix(b + word + 0x9e3779b97f4a7c15ULL);
+    }
+  }
+  hash[0] = a;
+  hash[1] = b;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+#include "fraction.h"
+
+size_t canonicalArenaSize(int rows);
+int canonicalPD(int rows, tangleInt pdCode[][7], arena *scratch);
+void hashPD(int rows, tangleInt pdCode[][7], uint64_t hash[2]);
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stdlib.h>
+
+/*
+  Entry of a pdCode matrix. Columns 0-3 and 6 hold arc labels and the
+  operation, columns 4 and 5 the numerator and denominator of the tangle's
+  fraction. Fractions of rational tangles grow like Fibonacci numbers in the
+  number of crossings, so they outgrow 32 bits at around 45 crossings; 64 bits
+  last to around 90.
+*/
+typedef long long tangleInt;
+
+/*
+  A reduction whose fractions outgrow tangleInt is redone with a
+  bigFractions pool (bigint.h) attached to its thread. While it is,
+  columns 4 and 5 hold plain values below FRACTION_BIG in magnitude and
+  handles to the pool's values past it, and the fraction functions below
+  work on either. A handle keeps the sign of its value, so negating it and
+  comparing it with 0, 1 or -1 need no help.
+*/
+#define FRACTION_BIG ((tangleInt)1 << 62)
+
+typedef struct bigFractions bigFractions;
+extern _Thread_local bigFractions *activeBig;
+
+tangleInt bigFractionAdd(tangleInt a, tangleInt b);
+tangleInt bigFractionMul(tangleInt a, tangleInt b);
+tangleInt bigFractionDiv(tangleInt a, tangleInt b);
+tangleInt bigFractionMod(tangleInt a, tangleInt b);
+int bigFractionAbsLess(tangleInt a, tangleInt b);
+
+/* Whether value is a handle to a value in the attached pool */
+static inline int fractionIsBig(tangleInt value) {
+  return activeBig != NULL && (value >= FRACTION_BIG || value <= -FRACTION_BIG);
+}
+
+/*
+  Fraction arithmetic that notices when a result does not fit. *overflow is
+  set and left set, so a whole reduction can be checked once at the end.
+*/
+static inline tangleInt fractionAdd(tangleInt a, tangleInt b, int *overflow) {
+  tangleInt sum;
+  if (activeBig != NULL) {
+    return bigFractionAdd(a, b);
+  }
+  if (__builtin_add_overflow(a, b, &sum)) {
+    *overflow = 1;
+  }
+  return sum;
+}
+
+static inline tangleInt fractionMul(tangleInt a, tangleInt b, int *overflow) {
+  tangleInt product;
+  if (activeBig != NULL) {
+    return bigFractionMul(a, b);
+  }
+  if (__builtin_mul_overflow(a, b, &product)) {
+    *overflow = 1;
+  }
+  return product;
+}
+
+/* a / b and a % b as C has them, rounding the quotient toward zero */
+static inline tangleInt fractionDiv(tangleInt a, tangleInt b) {
+  return activeBig != NULL ? bigFractionDiv(a, b) : a / b;
+}
+
+static inline tangleInt fractionMod(tangleInt a, tangleInt b) {
+  return activeBig != NULL ? bigFractionMod(a, b) : a % b;
+}
+
+/* |a| < |b| */
+static inline int fractionAbsLess(tangleInt a, tangleInt b) {
+  return activeBig != NULL ? bigFractionAbsLess(a, b) : llabs(a) < llabs(b);
+}
@@ -0,0 +1,1176 @@
+#include "generate.h"
+#include "fraction.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+  PD codes of rational tangles, written as pdCodes.txt records
+  ("[ a  b  c ]", the fraction, the PD code, separated by tabs) that
+  pdToConwayTangles -b reads back.
+
+  A tangle is built up crossing by crossing. Ports of a crossing are its
+  clocks SW, SE, NE, NW; the four ends of a tangle are kept the same way. For
+  the Conway vector [a1 .. an], an is added horizontally, a(n-1) vertically
+  and so on: |ai| crossings joined to the east ends of the tangle so far, or
+  to its south ends. Sums and products of tangles join whole pieces the same
+  way. Arcs are then labelled by walking each strand from the ends SW, NW,
+  NE, SE in turn, then any closed loops, and each crossing is written from
+  the port where its over-strand enters, the convention pdToConway reads.
+*/
+
+enum { SW, SE, NE, NW };
+
+typedef struct tangleBuilder {
+  int crossings;
+  int *over;     // 0 when the over-strand runs SW-NE, 1 when SE-NW
+  int *link;     // port joined to each port 4*crossing + clock, -1 at an end
+  int *label;    // arc at each port
+  int *enter;    // clock where the over-strand enters each crossing
+} tangleBuilder;
+
+/* Adds a lone crossing of sign, its ports becoming the ends of piece */
+static void newCrossing(tangleBuilder *b, int sign, int piece[4]) {
+  int c = b->crossings++;
+
+  b->over[c] = sign > 0 ? 1 : 0;
+  for (int p = 0; p < 4; p++) {
+    b->link[4 * c + p] = -1;
+    piece[p] = 4 * c + p;
+  }
+}
+
+/* Joins piece to the east (horizontal) or south side of the tangle with the given ends */
+static void joinTangles(tangleBuilder *b, int ends[4], const int piece[4], int horizontal) {
+  int *link = b->link;
+
+  if (horizontal) {
+    link[ends[NE]] = piece[NW];
+    link[piece[NW]] = ends[NE];
+    link[ends[SE]] = piece[SW];
+    link[piece[SW]] = ends[SE];
+    ends[NE] = piece[NE];
+    ends[SE] = piece[SE];
+  } else {
+    link[ends[SW]] = piece[NW];
+    link[piece[NW]] = ends[SW];
+    link[ends[SE]] = piece[NE];
+    link[piece[NE]] = ends[SE];
+    ends[SW] = piece[SW];
+    ends[SE] = piece[SE];
+  }
+}
+
+/* Adds the crossings of a Conway vector as a new piece with the given ends */
+static void addRational(tangleBuilder *b, const int vector[], int length, int ends[4]) {
+  int first = 1;
+
+  for (int i = 0; i < length; i++) {
+    int horizontal = (length - 1 - i) % 2 == 0;
+    int sign = vector[i] > 0 ? 1 : -1;
+    for (int j = 0; j < abs(vector[i]); j++) {
+      int piece[4];
+      newCrossing(b, sign, first ? ends : piece);
+      if (!first) {
+        joinTangles(b, ends, piece, horizontal);
+      }
+      first = 0;
+    }
+  }
+}
+
+/*
+  Labels the strand entering the tangle at port, starting from label, or the
+  closed loop through port when it never leaves
+*/
+static int walkStrand(tangleBuilder *b, int port, int label) {
+  int first = port;
+  int firstLabel = label;
+
+  b->label[port] = label;
+  while (1) {
+    int c = port >> 2;
+    int p = port & 3;
+    if (b->over[c] == (p & 1)) {
+      b->enter[c] = p;
+    }
+    int out = port ^ 2;
+    port = b->link[out];
+    if (port == first) {
+      b->label[out] = firstLabel;
+      return label + 1;
+    }
+    b->label[out] = ++label;
+    if (port < 0) {
+      return label + 1;
+    }
+    b->label[port] = label;
+  }
+}
+
+static void labelTangle(tangleBuilder *b, const int ends[4]) {
+  static const int order[4] = {SW, NW, NE, SE};
+  int label = 1;
+
+  for (int i = 0; i < 4 * b->crossings; i++) {
+    b->label[i] = 0;
+  }
+  for (int e = 0; e < 4; e++) {
+    if (b->label[ends[order[e]]] == 0) {
+      label = walkStrand(b, ends[order[e]], label);
+    }
+  }
+  for (int i = 0; i < 4 * b->crossings; i++) {
+    if (b->label[i] == 0) {
+      label = walkStrand(b, i, label);
+    }
+  }
+}
+
+static void buildVector(tangleBuilder *b, const int vector[], int length) {
+  int ends[4];
+
+  b->crossings = 0;
+  addRational(b, vector, length, ends);
+  labelTangle(b, ends);
+}
+
+/*
+  Output is assembled here and handed to stdio in large pieces. A record is
+  written without bounds checks once recordSize bytes are known to be free.
+*/
+#define GENERATE_BUFFER (1 << 16)
+
+typedef struct generateBuffer {
+  FILE *out;
+  char *text;
+  size_t size;
+  size_t length;
+} generateBuffer;
+
+/* At most 21 bytes per number and its separator, plus the brackets */
+static size_t recordSize(int crossings, int length) {
+  return (size_t)(4 * crossings + length + 2) * 22 + 16;
+}
+
+static void flushBuffer(generateBuffer *buf) {
+  fwrite(buf->text, 1, buf->length, buf->out);
+  buf->length = 0;
+}
+
+static char *putText(char *at, const char *text) {
+  while (*text) {
+    *at++ = *text++;
+  }
+  return at;
+}
+
+static char *putNumber(char *at, tangleInt n) {
+  // Arc labels, the bulk of the output, are small
+  if (n >= 0 && n < 100) {
+    if (n >= 10) {
+      *at++ = '0' + n / 10;
+    }
+    *at++ = '0' + n % 10;
+    return at;
+  }
+  char digits[24];
+  int count = 0;
+  unsigned long long u = n < 0 ? -(unsigned long long)n : (unsigned long long)n;
+
+  if (n < 0) {
+    *at++ = '-';
+  }
+  do {
+    digits[count++] = '0' + u % 10;
+    u /= 10;
+  } while (u > 0);
+  while (count > 0) {
+    *at++ = digits[--count];
+  }
+  return at;
+}
+
+/* Writes the PD code, each crossing from where its over-strand enters */
+static char *putPD(char *at, tangleBuilder *b) {
+  *at++ = '[';
+  for (int c = 0; c < b->crossings; c++) {
+    if (c > 0) {
+      *at++ = ',';
+    }
+    *at++ = '[';
+    for (int k = 0; k < 4; k++) {
+      if (k > 0) {
+        *at++ = ',';
+      }
+      at = putNumber(at, b->label[4 * c + (b->enter[c] + k) % 4]);
+    }
+    *at++ = ']';
+  }
+  *at++ = ']';
+  return at;
+}
+
+/*
+  Writes one record. The fraction of [a1 .. an] is an + 1/(a(n-1) + ...),
+  printed like pdCodes.txt with any sign on the denominator, or ? when it
+  does not fit in a tangleInt.
+*/
+static void putRecord(generateBuffer *buf, tangleBuilder *b, const int vector[], int length) {
+  tangleInt num = vector[0];
+  tangleInt den = 1;
+  int overflow = 0;
+
+  for (int i = 1; i < length; i++) {
+    tangleInt next = fractionAdd(fractionMul(vector[i], num, &overflow), den, &overflow);
+    den = num;
+    num = next;
+  }
+
+  if (buf->length + recordSize(b->crossings, length) > buf->size) {
+    flushBuffer(buf);
+  }
+  char *at = buf->text + buf->length;
+  at = putText(at, "[ ");
+  for (int i = 0; i < length; i++) {
+    if (i > 0) {
+      at = putText(at, "  ");
+    }
+    at = putNumber(at, vector[i]);
+  }
+  at = putText(at, " ]\t");
+  if (overflow) {
+    *at++ = '?';
+  } else {
+    if ((num < 0) != (den < 0) && num != 0) {
+      num = llabs(num);
+      den = -llabs(den);
+    } else {
+      num = llabs(num);
+      den = llabs(den);
+    }
+    at = putNumber(at, num);
+    *at++ = '/';
+    at = putNumber(at, den);
+  }
+  *at++ = '\t';
+  at = putPD(at, b);
+  *at++ = '\n';
+  buf->length = at - buf->text;
+}
+
+static generateBuffer *newBuffer(FILE *out, int crossings) {
+  generateBuffer *buf = malloc(sizeof(generateBuffer));
+  if (buf == NULL) {
+    return NULL;
+  }
+  buf->out = out;
+  buf->length = 0;
+  buf->size = GENERATE_BUFFER + recordSize(crossings, crossings + 1);
+  buf->text = malloc(buf->size);
+  if (buf->text == NULL) {
+    free(buf);
+    return NULL;
+  }
+  return buf;
+}
+
+static void freeBuffer(generateBuffer *buf) {
+  if (buf != NULL) {
+    flushBuffer(buf);
+    free(buf->text);
+    free(buf);
+  }
+}
+
+static void freeBuilder(tangleBuilder *b) {
+  free(b->over);
+  free(b->enter);
+  free(b->link);
+  free(b->label);
+}
+
+static int allocBuilder(tangleBuilder *b, int crossings) {
+  b->over = malloc(crossings * sizeof(int));
+  b->enter = malloc(crossings * sizeof(int));
+  b->link = malloc(4 * crossings * sizeof(int));
+  b->label = malloc(4 * crossings * sizeof(int));
+  if (b->over && b->enter && b->link && b->label) {
+    return 0;
+  }
+  freeBuilder(b);
+  return -1;
+}
+
+/*
+  Writes the record of one Conway vector, innermost term first as in
+  pdCodes.txt. Returns 0, or -1 when the vector has no crossings or memory
+  ran out.
+*/
+int generateVector(FILE *out, const int vector[], int length) {
+  tangleBuilder b;
+  int crossings = 0;
+
+  for (int i = 0; i < length; i++) {
+    crossings += abs(vector[i]);
+  }
+  if (crossings == 0) {
+    return -1;
+  }
+  if (allocBuilder(&b, crossings) != 0) {
+    return -1;
+  }
+  generateBuffer *buf = newBuffer(out, crossings + length);
+  if (buf == NULL) {
+    freeBuilder(&b);
+    return -1;
+  }
+  buildVector(&b, vector, length);
+  putRecord(buf, &b, vector, length);
+  freeBuffer(buf);
+  freeBuilder(&b);
+  return 0;
+}
+
+static const char *skipSpace(const char *c) {
+  while (*c == ' ' || *c == '\t') {
+    c++;
+  }
+  return c;
+}
+
+static const char *buildExpression(tangleBuilder *b, const char *c, int ends[4], int terms[]);
+
+/* A Conway vector in brackets or an expression in parentheses; NULL on a syntax error */
+static const char *buildTerm(tangleBuilder *b, const char *c, int ends[4], int terms[]) {
+  c = skipSpace(c);
+  if (*c == '(') {
+    c = buildExpression(b, c + 1, ends, terms);
+    if (c == NULL || *(c = skipSpace(c)) != ')') {
+      return NULL;
+    }
+    return c + 1;
+  }
+  if (*c != '[') {
+    return NULL;
+  }
+  int length = 0;
+  char *end;
+  c = skipSpace(c + 1);
+  while (*c != ']') {
+    long term = strtol(c, &end, 10);
+    if (end == c) {
+      return NULL;
+    }
+    terms[length++] = term;
+    c = skipSpace(end);
+  }
+  int first = b->crossings;
+  addRational(b, terms, length, ends);
+  return b->crossings > first ? c + 1 : NULL;
+}
+
+/* Terms joined by + (side by side) and * (one above the other), from the left */
+static const char *buildExpression(tangleBuilder *b, const char *c, int ends[4], int terms[]) {
+  c = buildTerm(b, c, ends, terms);
+  while (c != NULL && (*(c = skipSpace(c)) == '+' || *c == '*')) {
+    int piece[4];
+    int horizontal = *c == '+';
+    c = buildTerm(b, c + 1, piece, terms);
+    if (c != NULL) {
+      joinTangles(b, ends, piece, horizontal);
+    }
+  }
+  return c;
+}
+
+/*
+  Writes the record of an algebraic tangle given the way -a names them, as
+  in ([2 1]+[3 0])*[-2], with ? for its fraction. Returns 0, or -1 when the
+  text is not such an expression or memory ran out.
+*/
+int generateExpression(FILE *out, const char *text) {
+  tangleBuilder b;
+  int crossings = 0;
+  int count = 0;
+  char *end;
+
+  for (const char *c = text; *c != 0; c++) {
+    long term = strtol(c, &end, 10);
+    if (end != c) {
+      crossings += labs(term);
+      count++;
+      c = end - 1;
+    }
+  }
+  if (crossings == 0 || allocBuilder(&b, crossings) != 0) {
+    return -1;
+  }
+  int *terms = malloc(count * sizeof(int));
+  generateBuffer *buf = newBuffer(out, crossings);
+  int ends[4];
+  b.crossings = 0;
+  const char *rest = terms != NULL && buf != NULL ? buildExpression(&b, text, ends, terms) : NULL;
+  int status = rest != NULL && *skipSpace(rest) == 0 ? 0 : -1;
+  if (status == 0) {
+    labelTangle(&b, ends);
+    fprintf(out, "%s\t?\t", text);
+    char *at = putPD(buf->text, &b);
+    *at++ = '\n';
+    buf->length = at - buf->text;
+  }
+  freeBuffer(buf);
+  free(terms);
+  freeBuilder(&b);
+  return status;
+}
+
+/*
+  The composition of n given by the bits of mask, bit i set ending a term
+  after crossing i + 1, as a Conway vector from its innermost term. Returns
+  its length, or -1 when the innermost term is 1 and there are more, which
+  is not a regular continued fraction.
+*/
+static int composition(int n, long mask, int vector[]) {
+  int length = 0;
+  int term = 1;
+
+  for (int i = 0; i < n - 1; i++) {
+    if (mask & (1L << i)) {
+      vector[length++] = term;
+      term = 1;
+    } else {
+      term++;
+    }
+  }
+  vector[length++] = term;
+  return length > 1 && vector[0] < 2 ? -1 : length;
+}
+
+/*
+  Writes every rational tangle of 1 to maxCrossings crossings once: each
+  composition [a1 .. an] of the crossing count with a1 > 1 unless n = 1
+  (so the continued fraction is the regular one), with both signs, and each
+  of those rotated by appending a 0 ([1 0] is [1] again and is skipped).
+  Returns the number of records, or -1 when memory ran out.
+*/
+long generateRational(FILE *out, int maxCrossings) {
+  tangleBuilder b;
+  long records = 0;
+
+  if (maxCrossings < 1) {
+    return 0;
+  }
+  generateBuffer *buf = newBuffer(out, maxCrossings);
+  int *vector = malloc((maxCrossings + 1) * sizeof(int));
+  if (buf == NULL || vector == NULL || allocBuilder(&b, maxCrossings) != 0) {
+    freeBuffer(buf);
+    free(vector);
+    return -1;
+  }
+
+  for (int n = 1; n <= maxCrossings; n++) {
+    for (long mask = 0; mask < 1L << (n - 1); mask++) {
+      int length = composition(n, mask, vector);
+      if (length < 0) {
+        continue;
+      }
+      for (int sign = 1; sign >= -1; sign -= 2) {
+        for (int rotate = 0; rotate < 2; rotate++) {
+          if (rotate && n == 1) {
+            continue;
+          }
+          vector[length] = 0;
+          buildVector(&b, vector, length + rotate);
+          putRecord(buf, &b, vector, length + rotate);
+          records++;
+        }
+        for (int i = 0; i < length; i++) {
+          vector[i] = -vector[i];
+        }
+      }
+    }
+  }
+  freeBuffer(buf);
+  freeBuilder(&b);
+  free(vector);
+  return records;
+}
+
+/*
+  Algebraic tangles are written as token strings: a rational piece is its
+  index in the rational table, and a sum or product of k tangles is a node
+  token followed by the tokens of its k children.
+*/
+enum { SUM_NODE, PRODUCT_NODE };
+
+#define NODE_TOKEN(kind, k) (-2 * (k) - (kind))
+#define NODE_KIND(token) ((-(token)) % 2)
+#define NODE_CHILDREN(token) ((-(token)) / 2)
+
+/* Rational pieces, all those of c crossings at first[c] .. first[c + 1] - 1 */
+typedef struct rationalTable {
+  int *terms;
+  long *start;     // of each vector in terms
+  int *length;
+  int *first;
+  int *integer;    // [m] at 2 * m, [-m] at 2 * m + 1
+  int *vertical;   // [m 0] and [-m 0] the same way, [1] and [-1] for m = 1
+  int count;
+} rationalTable;
+
+/* Expressions of one kind and crossing count, kept as children for larger ones */
+typedef struct exprList {
+  int *tokens;
+  long used;
+  long capacity;
+  long *offset;
+  long count;
+  long slots;
+} exprList;
+
+typedef struct algebraicEnum {
+  int maxCrossings;
+  int stored;            // lists are kept up to this many crossings
+  rationalTable table;
+  exprList *lists[2];    // sums and products by crossing count
+  int *stack;            // the expression being built, its node token first
+  int depth;
+  int *image;            // a flipped copy of it
+  tangleBuilder b;
+  tangleInt (*pdCode)[7];
+  char *name;
+  tangleVisit visit;
+  void *context;
+  long records;
+  int failed;
+} algebraicEnum;
+
+static int tableBuild(rationalTable *t, int maxCrossings) {
+  long slots = 4L << maxCrossings;
+  int vector[maxCrossings + 1];
+  long used = 0;
+
+  t->terms = malloc(slots * (maxCrossings + 1) * sizeof(int));
+  t->start = malloc(slots * sizeof(long));
+  t->length = malloc(slots * sizeof(int));
+  t->first = malloc((maxCrossings + 2) * sizeof(int));
+  t->integer = malloc(2 * (maxCrossings + 1) * sizeof(int));
+  t->vertical = malloc(2 * (maxCrossings + 1) * sizeof(int));
+  t->count = 0;
+  if (t->terms == NULL || t->start == NULL || t->length == NULL || t->first == NULL ||
+      t->integer == NULL || t->vertical == NULL) {
+    return -1;
+  }
+  t->first[0] = t->first[1] = 0;
+  for (int n = 1; n <= maxCrossings; n++) {
+    for (long mask = 0; mask < 1L << (n - 1); mask++) {
+      int length = composition(n, mask, vector);
+      if (length < 0) {
+        continue;
+      }
+      for (int sign = 0; sign < 2; sign++) {
+        for (int rotate = 0; rotate < 2; rotate++) {
+          if (rotate && n == 1) {
+            continue;
+          }
+          int i = t->count++;
+          t->start[i] = used;
+          t->length[i] = length + rotate;
+          for (int j = 0; j < length; j++) {
+            t->terms[used++] = sign ? -vector[j] : vector[j];
+          }
+          if (rotate) {
+            t->terms[used++] = 0;
+          }
+          if (length == 1 && !rotate) {
+            t->integer[2 * n + sign] = i;
+          }
+          if (length == 1 && (rotate || n == 1)) {
+            t->vertical[2 * n + sign] = i;
+          }
+        }
+      }
+    }
+    t->first[n + 1] = t->count;
+  }
+  return 0;
+}
+
+static void tableFree(rationalTable *t) {
+  free(t->terms);
+  free(t->start);
+  free(t->length);
+  free(t->first);
+  free(t->integer);
+  free(t->vertical);
+}
+
+static const int *rationalTerms(const rationalTable *t, int i) {
+  return t->terms + t->start[i];
+}
+
+/*
+  Whether rational i may be a child of a sum or product. An integer tangle
+  in a sum, or a vertical one ([m 0], or [1]) in a product, would only
+  twist the rest, so those are kept apart as the node's last child.
+*/
+static int childAllowed(const rationalTable *t, int kind, int i) {
+  const int *terms = rationalTerms(t, i);
+  if (kind == SUM_NODE) {
+    return t->length[i] > 1;
+  }
+  return !(t->length[i] == 1 && abs(terms[0]) == 1) &&
+         !(t->length[i] == 2 && terms[1] == 0);
+}
+
+/* Whether rational i, when it is the last child of a node, is the twist kept apart */
+static int isTwist(const rationalTable *t, int kind, int i) {
+  return !childAllowed(t, kind, i);
+}
+
+static int exprSize(const int *e) {
+  if (e[0] >= 0) {
+    return 1;
+  }
+  int size = 1;
+  for (int k = 0; k < NODE_CHILDREN(e[0]); k++) {
+    size += exprSize(e + size);
+  }
+  return size;
+}
+
+/*
+  Copies e into out as seen after turning it over about the vertical axis
+  (flipSums) and/or the horizontal one (flipProducts). Turning a sum about
+  the vertical axis reverses its children, and a flype then carries its
+  twist back to the end, turning each child over the other way as it goes.
+  Rational pieces look the same either way up. Returns the size of e.
+*/
+static int flipExpr(const rationalTable *t, const int *e, int *out, int flipSums, int flipProducts) {
+  out[0] = e[0];
+  if (e[0] >= 0) {
+    return 1;
+  }
+  int kind = NODE_KIND(e[0]);
+  int k = NODE_CHILDREN(e[0]);
+  int child[k];
+  int size = 1;
+  for (int i = 0; i < k; i++) {
+    child[i] = size;
+    size += exprSize(e + size);
+  }
+  int twist = e[child[k - 1]] >= 0 && isTwist(t, kind, e[child[k - 1]]);
+  int movable = k - twist;
+  int reverse = kind == SUM_NODE ? flipSums : flipProducts;
+  int sums = flipSums;
+  int products = flipProducts;
+  if (reverse && twist) {
+    sums ^= kind == PRODUCT_NODE;
+    products ^= kind == SUM_NODE;
+  }
+
+  int at = 1;
+  for (int i = 0; i < movable; i++) {
+    int from = child[reverse ? movable - 1 - i : i];
+    at += flipExpr(t, e + from, out + at, sums, products);
+  }
+  if (twist) {
+    out[at++] = e[child[k - 1]];
+  }
+  return size;
+}
+
+/* Whether e comes first among its images turned over about either axis or both */
+static int isFirstImage(algebraicEnum *a, const int *e, int size) {
+  static const int flips[3][2] = {{1, 0}, {0, 1}, {1, 1}};
+
+  for (int f = 0; f < 3; f++) {
+    flipExpr(&a->table, e, a->image, flips[f][0], flips[f][1]);
+    for (int i = 0; i < size; i++) {
+      if (a->image[i] != e[i]) {
+        if (a->image[i] < e[i]) {
+          return 0;
+        }
+        break;
+      }
+    }
+  }
+  return 1;
+}
+
+/* Adds the crossings of e to the builder as a piece with the given ends */
+static int buildExpr(algebraicEnum *a, const int *e, int ends[4]) {
+  if (e[0] >= 0) {
+    addRational(&a->b, rationalTerms(&a->table, e[0]), a->table.length[e[0]], ends);
+    return 1;
+  }
+  int size = 1;
+  for (int k = 0; k < NODE_CHILDREN(e[0]); k++) {
+    int piece[4];
+    size += buildExpr(a, e + size, k == 0 ? ends : piece);
+    if (k > 0) {
+      joinTangles(&a->b, ends, piece, NODE_KIND(e[0]) == SUM_NODE);
+    }
+  }
+  return size;
+}
+
+/* Writes e as [2 1]+([3 0]*[-2]), returning the end of the text */
+static char *putExpr(algebraicEnum *a, const int *e, char *at, int *size) {
+  if (e[0] >= 0) {
+    const int *terms = rationalTerms(&a->table, e[0]);
+    *at++ = '[';
+    for (int i = 0; i < a->table.length[e[0]]; i++) {
+      if (i > 0) {
+        *at++ = ' ';
+      }
+      at = putNumber(at, terms[i]);
+    }
+    *at++ = ']';
+    *size = 1;
+    return at;
+  }
+  int used = 1;
+  for (int k = 0; k < NODE_CHILDREN(e[0]); k++) {
+    int child;
+    int nested = e[used] < 0;
+    if (k > 0) {
+      *at++ = NODE_KIND(e[0]) == SUM_NODE ? '+' : '*';
+    }
+    if (nested) {
+      *at++ = '(';
+    }
+    at = putExpr(a, e + used, at, &child);
+    if (nested) {
+      *at++ = ')';
+    }
+    used += child;
+  }
+  *size = used;
+  return at;
+}
+
+static int listAppend(exprList *list, const int *e, int size) {
+  if (list->used + size > list->capacity) {
+    long capacity = 2 * list->capacity + size + 1024;
+    int *tokens = realloc(list->tokens, capacity * sizeof(int));
+    if (tokens == NULL) {
+      return -1;
+    }
+    list->tokens = tokens;
+    list->capacity = capacity;
+  }
+  if (list->count == list->slots) {
+    long slots = 2 * list->slots + 256;
+    long *offset = realloc(list->offset, slots * sizeof(long));
+    if (offset == NULL) {
+      return -1;
+    }
+    list->offset = offset;
+    list->slots = slots;
+  }
+  list->offset[list->count++] = list->used;
+  memcpy(list->tokens + list->used, e, size * sizeof(int));
+  list->used += size;
+  return 0;
+}
+
+/* The builder's PD code as parsePD would leave it, 0-based */
+static void builderPD(const tangleBuilder *b, tangleInt pdCode[][7]) {
+  for (int c = 0; c < b->crossings; c++) {
+    for (int k = 0; k < 4; k++) {
+      pdCode[c][k] = b->label[4 * c + (b->enter[c] + k) % 4] - 1;
+    }
+    pdCode[c][4] = -1;
+    pdCode[c][5] = 1;
+    pdCode[c][6] = 0;
+  }
+}
+
+/* The expression on the stack is complete: keep it as a child and visit it */
+static void finishExpr(algebraicEnum *a, int kind, int crossings) {
+  const int *e = a->stack;
+  int size = a->depth;
+
+  if (crossings <= a->stored && listAppend(&a->lists[kind][crossings], e, size) != 0) {
+    a->failed = 1;
+    return;
+  }
+  if (!isFirstImage(a, e, size)) {
+    return;
+  }
+
+  int ends[4];
+  int shape = SHAPE_NESTED;
+  a->b.crossings = 0;
+  buildExpr(a, e, ends);
+  labelTangle(&a->b, ends);
+  builderPD(&a->b, a->pdCode);
+  int rational = 1;
+  for (int i = 1; i < size; i++) {
+    rational &= e[i] >= 0;
+  }
+  if (rational) {
+    shape = kind == SUM_NODE ? SHAPE_SUM : SHAPE_PRODUCT;
+  }
+  int used;
+  *putExpr(a, e, a->name, &used) = 0;
+  a->visit(a->context, a->name, shape, a->b.crossings, a->pdCode);
+  a->records++;
+}
+
+/*
+  Extends the node on the stack with children of remaining crossings in
+  every way, then adds its twist, if any, as the last child.
+*/
+static void addChildren(algebraicEnum *a, int kind, int crossings, int remaining, int count, int twist) {
+  if (a->failed) {
+    return;
+  }
+  if (remaining == 0) {
+    if (count >= 2) {
+      a->stack[0] = NODE_TOKEN(kind, count + (twist >= 0));
+      if (twist >= 0) {
+        a->stack[a->depth++] = twist;
+      }
+      finishExpr(a, kind, crossings);
+      a->depth -= twist >= 0;
+    }
+    return;
+  }
+  // Every child leaves room for another, so none has more than stored crossings
+  for (int c = 2; c <= remaining && c <= a->stored; c++) {
+    if (remaining - c == 1) {
+      continue;
+    }
+    for (int i = a->table.first[c]; i < a->table.first[c + 1]; i++) {
+      if (childAllowed(&a->table, kind, i)) {
+        a->stack[a->depth++] = i;
+        addChildren(a, kind, crossings, remaining - c, count + 1, twist);
+        a->depth--;
+      }
+    }
+    exprList *list = &a->lists[!kind][c];
+    for (long j = 0; j < list->count; j++) {
+      const int *child = list->tokens + list->offset[j];
+      int size = exprSize(child);
+      memcpy(a->stack + a->depth, child, size * sizeof(int));
+      a->depth += size;
+      addChildren(a, kind, crossings, remaining - c, count + 1, twist);
+      a->depth -= size;
+    }
+  }
+}
+
+/*
+  Enumerates the algebraic tangles of 4 to maxCrossings crossings that are
+  not rational, building them from the rational tangles with sums (+) and
+  products (*) as pdCode's sixth column does, and hands each one's PD code,
+  0-based like parsePD's, to visit.
+
+  Sums are taken with any number of children and no child that is itself a
+  sum, and likewise for products, so each way of bracketing appears once. A
+  node has at least two children that are not twists, and its twists are
+  gathered into one last child: m crossings ([m]) at the end of a sum, or
+  [m 0] at the bottom of a product, since a flype slides them there. Of a
+  tangle and its images turned over about the vertical or horizontal axis,
+  or both, only the first in token order is visited. Returns the number of
+  tangles visited, or -1 when memory ran out.
+*/
+long generateAlgebraic(int maxCrossings, tangleVisit visit, void *context) {
+  algebraicEnum a;
+  long records = -1;
+
+  if (maxCrossings < 4) {
+    return 0;
+  }
+  memset(&a, 0, sizeof(a));
+  a.maxCrossings = maxCrossings;
+  a.stored = maxCrossings - 2;
+  a.visit = visit;
+  a.context = context;
+  a.lists[SUM_NODE] = calloc(maxCrossings + 1, sizeof(exprList));
+  a.lists[PRODUCT_NODE] = calloc(maxCrossings + 1, sizeof(exprList));
+  a.stack = malloc((2 * maxCrossings + 4) * sizeof(int));
+  a.image = malloc((2 * maxCrossings + 4) * sizeof(int));
+  a.pdCode = malloc(maxCrossings * sizeof(*a.pdCode));
+  // At most 4 characters a term, a 0 term per crossing, and brackets around each
+  a.name = malloc(16 * maxCrossings + 16);
+  if (a.lists[SUM_NODE] != NULL && a.lists[PRODUCT_NODE] != NULL && a.stack != NULL &&
+      a.image != NULL && a.pdCode != NULL && a.name != NULL &&
+      tableBuild(&a.table, maxCrossings - 2) == 0 && allocBuilder(&a.b, maxCrossings) == 0) {
+    for (int crossings = 4; crossings <= maxCrossings && !a.failed; crossings++) {
+      for (int kind = SUM_NODE; kind <= PRODUCT_NODE; kind++) {
+        for (int m = 0; m <= crossings - 4; m++) {
+          for (int sign = 0; sign < (m > 0 ? 2 : 1); sign++) {
+            int twist = -1;
+            if (m > 0) {
+              twist = kind == SUM_NODE ? a.table.integer[2 * m + sign] : a.table.vertical[2 * m + sign];
+            }
+            a.depth = 1;
+            addChildren(&a, kind, crossings, crossings - m, 0, twist);
+          }
+        }
+      }
+    }
+    records = a.failed ? -1 : a.records;
+    freeBuilder(&a.b);
+  }
+  for (int kind = SUM_NODE; kind <= PRODUCT_NODE; kind++) {
+    for (int c = 0; a.lists[kind] != NULL && c <= maxCrossings; c++) {
+      free(a.lists[kind][c].tokens);
+      free(a.lists[kind][c].offset);
+    }
+    free(a.lists[kind]);
+  }
+  tableFree(&a.table);
+  free(a.stack);
+  free(a.image);
+  free(a.pdCode);
+  free(a.name);
+  return records;
+}
+
+/*
+  A tangle diagram is a connected map on the sphere: its crossings, and one
+  more vertex where the outside of the disk is shrunk to a point, whose four
+  edges are the ends. Darts 4v .. 4v + 3 go counterclockwise round vertex v,
+  as the ports of a crossing do. Seen from outside the disk the ends go round
+  the other way, so dart i of vertex 0 is the end outsideEnds[i].
+*/
+static const int outsideEnds[4] = {SW, NW, NE, SE};
+
+typedef struct diagramEnum {
+  int maxCrossings;
+  int vertices;          // the ends, then the crossings in the order they were reached
+  int *partner;          // dart each dart is joined to, -1 while it is open
+  int *start;            // port each component is walked from, forwards then backwards
+  int components;
+  tangleBuilder b;
+  tangleInt (*pdCode)[7];
+  char name[24];
+  tangleVisit visit;
+  void *context;
+  long diagrams;
+  long records;
+} diagramEnum;
+
+/* Next dart counterclockwise round the same vertex */
+static int nextDart(int d) {
+  return (d & ~3) | ((d + 1) & 3);
+}
+
+/*
+  Writes the open darts after d on the face d is open to into open[] and
+  returns how many there are. Going round a face an open dart is passed
+  over like the tip of an edge, so d can be joined to exactly these
+  without leaving the sphere.
+*/
+static int openOnFace(const diagramEnum *D, int d, int open[]) {
+  int count = 0;
+  int x = nextDart(d);
+
+  while (x != d) {
+    if (D->partner[x] < 0) {
+      if (x > d) {
+        open[count++] = x;
+      }
+      x = nextDart(x);
+    } else {
+      x = nextDart(D->partner[x]);
+    }
+  }
+  return count;
+}
+
+/* Walks the strand entering at port, marking its ports, and returns the port it leaves by */
+static int traceStrand(const tangleBuilder *b, int port, char seen[]) {
+  while (1) {
+    int out = port ^ 2;
+    seen[port] = seen[out] = 1;
+    if (b->link[out] < 0) {
+      return out;
+    }
+    port = b->link[out];
+  }
+}
+
+/*
+  Visits the labelled diagram with each crossing written from either end of
+  its over-strand. Which end that is says nothing a PD code needs, so codes
+  come written both ways round, even along the one strand.
+*/
+static void visitTurns(diagramEnum *D) {
+  int crossings = D->b.crossings;
+
+  for (long turn = 0; turn < 1L << crossings; turn++) {
+    builderPD(&D->b, D->pdCode);
+    for (int c = 0; c < crossings; c++) {
+      if (turn >> c & 1) {
+        for (int k = 0; k < 2; k++) {
+          tangleInt label = D->pdCode[c][k];
+          D->pdCode[c][k] = D->pdCode[c][k + 2];
+          D->pdCode[c][k + 2] = label;
+        }
+      }
+    }
+    D->visit(D->context, D->name, SHAPE_DIAGRAM, crossings, D->pdCode);
+    D->records++;
+  }
+}
+
+/*
+  Labels the components of the diagram in every order, from depth on: each
+  strand from either end, each closed loop either way round. Loops labelled
+  one after the other give the same codes in either order, as may other
+  choices, and are visited as often as they come up.
+*/
+static void labelComponents(diagramEnum *D, int depth, unsigned used, int label) {
+  if (depth == D->components) {
+    visitTurns(D);
+    return;
+  }
+  for (int i = 0; i < D->components; i++) {
+    if (used & 1u << i) {
+      continue;
+    }
+    for (int way = 0; way < 2; way++) {
+      int next = walkStrand(&D->b, D->start[2 * i + way], label);
+      labelComponents(D, depth + 1, used | 1u << i, next);
+    }
+  }
+}
+
+/* Visits every PD code of the finished diagram, with each crossing either way over */
+static void visitDiagram(diagramEnum *D) {
+  tangleBuilder *b = &D->b;
+  int ports = 4 * (D->vertices - 1);
+  int ends[4];
+  char seen[ports];
+
+  b->crossings = D->vertices - 1;
+  for (int p = 0; p < ports; p++) {
+    int q = D->partner[p + 4];
+    b->link[p] = q < 4 ? -1 : q - 4;
+    seen[p] = 0;
+  }
+  for (int i = 0; i < 4; i++) {
+    ends[outsideEnds[i]] = D->partner[i] - 4;
+  }
+  D->components = 0;
+  for (int e = 0; e < 4; e++) {
+    int port = ends[e];
+    if (!seen[port]) {
+      D->start[2 * D->components] = port;
+      D->start[2 * D->components + 1] = traceStrand(b, port, seen);
+      D->components++;
+    }
+  }
+  for (int p = 0; p < ports; p++) {
+    if (!seen[p]) {
+      D->start[2 * D->components] = p;
+      D->start[2 * D->components + 1] = p ^ 2;
+      D->components++;
+      // round the loop, which is left through the port it was entered by
+      int port = p;
+      do {
+        seen[port] = seen[port ^ 2] = 1;
+        port = b->link[port ^ 2];
+      } while (port != p);
+    }
+  }
+
+  snprintf(D->name, sizeof(D->name), "%ld", ++D->diagrams);
+  for (long over = 0; over < 1L << b->crossings; over++) {
+    for (int c = 0; c < b->crossings; c++) {
+      b->over[c] = over >> c & 1;
+    }
+    labelComponents(D, 0, 0, 1);
+  }
+}
+
+/*
+  Extends the diagram by joining the lowest open dart from, onwards, to
+  another dart on its face or to a new crossing. A new crossing is turned so
+  that the dart joined to it is its first, and the crossings are numbered
+  in the order they are reached, so each diagram comes up exactly once. The
+  ends are not joined to each other, as a strand needs a crossing to be
+  written in a PD code.
+*/
+static void extendDiagram(diagramEnum *D, int from) {
+  int darts = 4 * D->vertices;
+  int d = from;
+
+  while (d < darts && D->partner[d] >= 0) {
+    d++;
+  }
+  if (d == darts) {
+    visitDiagram(D);
+    return;
+  }
+
+  int open[darts];
+  int count = openOnFace(D, d, open);
+  for (int i = 0; i < count; i++) {
+    int e = open[i];
+    if (e < 4 && d < 4) {
+      continue;
+    }
+    D->partner[d] = e;
+    D->partner[e] = d;
+    extendDiagram(D, d + 1);
+    D->partner[e] = -1;
+  }
+  if (D->vertices <= D->maxCrossings) {
+    int w = 4 * D->vertices++;
+    for (int p = 0; p < 4; p++) {
+      D->partner[w + p] = -1;
+    }
+    D->partner[d] = w;
+    D->partner[w] = d;
+    extendDiagram(D, d + 1);
+    D->vertices--;
+  }
+  D->partner[d] = -1;
+}
+
+/*
+  Enumerates every tangle diagram of 1 to maxCrossings crossings, connected
+  and without crossings that could be told apart only by their labels, and
+  hands visit the PD code of each way of labelling each one along its
+  strands: components in any order, each walked either way, and each
+  crossing written from either end of its over-strand. The name is the number of the
+  diagram. There are about 17 times as many diagrams with each crossing
+  more, so this is for small tangles only. Returns the number of codes
+  visited, or -1 when memory ran out.
+*/
+long generateDiagrams(int maxCrossings, tangleVisit visit, void *context) {
+  diagramEnum D;
+  int darts = 4 * (maxCrossings + 1);
+  long records = -1;
+
+  if (maxCrossings < 1) {
+    return 0;
+  }
+  memset(&D, 0, sizeof(D));
+  D.maxCrossings = maxCrossings;
+  D.visit = visit;
+  D.context = context;
+  D.partner = malloc(darts * sizeof(int));
+  D.start = malloc(2 * darts * sizeof(int));
+  D.pdCode = malloc(maxCrossings * sizeof(*D.pdCode));
+  if (D.partner != NULL && D.start != NULL && D.pdCode != NULL &&
+      allocBuilder(&D.b, maxCrossings) == 0) {
+    D.vertices = 1;
+    for (int i = 0; i < 4; i++) {
+      D.partner[i] = -1;
+    }
+    extendDiagram(&D, 0);
+    records = D.records;
+    freeBuilder(&D.b);
+  }
+  free(D.partner);
+  free(D.start);
+  free(D.pdCode);
+  return records;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdio.h>
+#include "fraction.h"
+
+/* How an enumerated algebraic tangle is put together */
+enum algebraicShape {
+  SHAPE_SUM,      // rational tangles added, a Montesinos tangle
+  SHAPE_PRODUCT,  // rational tangles multiplied, a Montesinos tangle turned 90 degrees
+  SHAPE_NESTED,   // sums and products of those
+  SHAPE_DIAGRAM   // any diagram at all, from generateDiagrams
+};
+
+/* Called with each enumerated tangle; pdCode may be changed */
+typedef void (*tangleVisit)(void *context, const char *name, int shape, int rows,
+                            tangleInt pdCode[][7]);
+
+long generateRational(FILE *out, int maxCrossings);
+int generateVector(FILE *out, const int vector[], int length);
+int generateExpression(FILE *out, const char *text);
+long generateAlgebraic(int maxCrossings, tangleVisit visit, void *context);
+long generateDiagrams(int maxCrossings, tangleVisit visit, void *context);
@@ -0,0 +1,487 @@
+#include "lookup.h"
+#include "canonical.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Keys per bucket on average; each bucket costs 4 bytes of displacement */
+#define LOOKUP_BUCKET_KEYS 4
+
+/* splitmix64 finaliser */
+static uint64_t mix(uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+/* x scaled from 0 .. 2^64 down to 0 .. n, cheaper than x % n */
+static uint64_t scaleDown(uint64_t x, uint64_t n) {
+  return (uint64_t)(((unsigned __int128)x * n) >> 64);
+}
+
+static uint64_t bucketOf(const uint64_t key[2], uint64_t buckets) {
+  return scaleDown(key[0], buckets);
+}
+
+static uint64_t slotOf(const uint64_t key[2], uint32_t displace, uint64_t slots) {
+  return scaleDown(mix(key[1] ^ displace * 0x9e3779b97f4a7c15ULL), slots);
+}
+
+/* Offsets of the parts of a table with header's sizes, returning the size of the file */
+static size_t lookupLayout(const lookupHeader *header, size_t *slots, size_t *records, size_t *text) {
+  size_t displace = header->buckets * sizeof(uint32_t);
+  *slots = sizeof(lookupHeader) + ((displace + 7) & ~(size_t)7);
+  *records = *slots + header->slots * sizeof(lookupSlot);
+  *text = *records + header->records * sizeof(lookupRecord);
+  return *text + header->textSize;
+}
+
+/*
+  Opens the table at path read-only. Returns 0, or -1 with errno set:
+  EINVAL when path is not a lookup table, ESTALE when its results came from
+  a build with another CONWAY_RESULT_VERSION.
+*/
+int lookupOpen(lookupTable *table, const char *path) {
+  struct stat st;
+  lookupHeader header;
+  size_t slots, records, text;
+
+  table->fd = open(path, O_RDONLY);
+  if (table->fd < 0) {
+    return -1;
+  }
+  if (fstat(table->fd, &st) != 0) {
+    goto fail;
+  }
+  if (pread(table->fd, &header, sizeof(header), 0) != sizeof(header) ||
+      memcmp(header.magic, LOOKUP_MAGIC, 8) != 0 ||
+      (off_t)lookupLayout(&header, &slots, &records, &text) != st.st_size) {
+    errno = EINVAL;  // not a lookup table
+    goto fail;
+  }
+  if (header.resultVersion != CONWAY_RESULT_VERSION) {
+    errno = ESTALE;
+    goto fail;
+  }
+  table->mapSize = st.st_size;
+  table->map = mmap(NULL, table->mapSize, PROT_READ, MAP_SHARED, table->fd, 0);
+  if (table->map == MAP_FAILED) {
+    goto fail;
+  }
+  table->header = (const lookupHeader *)table->map;
+  table->displace = (const uint32_t *)(table->map + sizeof(lookupHeader));
+  table->slots = (const lookupSlot *)(table->map + slots);
+  table->records = (const lookupRecord *)(table->map + records);
+  table->text = table->map + text;
+  return 0;
+
+fail:
+  close(table->fd);
+  return -1;
+}
+
+/* perror for lookupOpen, naming a table of another version for what it is */
+void lookupPerror(const char *path) {
+  if (errno == ESTALE) {
+    fprintf(stderr, "%s: results of another version of the reducer, rebuild it with make table\n", path);
+  } else {
+    perror(path);
+  }
+}
+
+/* The record of key, or NULL when the key is not in the table */
+const lookupRecord *lookupFind(const lookupTable *table, const uint64_t key[2]) {
+  const lookupHeader *header = table->header;
+  uint32_t displace = table->displace[bucketOf(key, header->buckets)];
+  const lookupSlot *slot = &table->slots[slotOf(key, displace, header->slots)];
+
+  if (slot->key[0] != key[0] || slot->key[1] != key[1] || slot->record == LOOKUP_EMPTY) {
+    return NULL;
+  }
+  return &table->records[slot->record];
+}
+
+static void unpackRecord(const lookupRecord *record, const char *text, tangleResult *result) {
+  resetResult(result);
+  result->status = record->status;
+  result->classification = record->classification;
+  result->writhe = record->writhe;
+  result->num = record->num;
+  result->den = record->den;
+  result->mirrorNum = record->mirrorNum;
+  result->mirrorDen = record->mirrorDen;
+  // as reduceTangle writes the vector of a rational tangle
+  if (record->conwayLength > 0) {
+    int closing;
+    int sign = record->num < 0 ? -1 : 1;
+    result->conwayLength = conwayTerms(llabs(record->num), record->den, result->conway,
+                                       CONWAY_MAX, &closing);
+    for (int i = 0; i < result->conwayLength; i++) {
+      result->conway[i] *= sign;
+    }
+  }
+  memcpy(result->decomposition, text, record->textLength);
+  result->decomposition[record->textLength] = 0;
+  result->decompositionLength = record->textLength;
+  result->truncated = record->truncated;
+  result->crossingsRemoved = record->crossingsRemoved;
+}
+
+/* Fills result from a record of the table, as pdToConwayResult would have */
+void lookupResult(const lookupTable *table, const lookupRecord *record, tangleResult *result) {
+  unpackRecord(record, table->text + record->textOffset, result);
+}
+
+void lookupClose(lookupTable *table) {
+  munmap(table->map, table->mapSize);
+  close(table->fd);
+}
+
+/* Sizes of the builder's sets when it starts; they double at half full */
+#define BUILDER_KEY_SET (1 << 16)
+#define BUILDER_RECORD_SET (1 << 10)
+
+int lookupBuilderInit(lookupBuilder *builder) {
+  memset(builder, 0, sizeof(*builder));
+  builder->keySetSize = BUILDER_KEY_SET;
+  builder->recordSetSize = BUILDER_RECORD_SET;
+  builder->keySet = calloc(builder->keySetSize, sizeof(uint64_t));
+  builder->recordSet = calloc(builder->recordSetSize, sizeof(uint64_t));
+  if (builder->keySet == NULL || builder->recordSet == NULL) {
+    lookupBuilderFree(builder);
+    return -1;
+  }
+  return 0;
+}
+
+/* Slot of keySet holding key, or the empty slot where it would go */
+static uint64_t keySetSlot(const lookupBuilder *builder, const uint64_t key[2]) {
+  uint64_t mask = builder->keySetSize - 1;
+  uint64_t i = key[0] & mask;
+  while (builder->keySet[i] != 0) {
+    const uint64_t *other = builder->keys[builder->keySet[i] - 1].key;
+    if (other[0] == key[0] && other[1] == key[1]) {
+      break;
+    }
+    i = (i + 1) & mask;
+  }
+  return i;
+}
+
+int lookupContains(const lookupBuilder *builder, const uint64_t key[2]) {
+  return builder->keySet[keySetSlot(builder, key)] != 0;
+}
+
+static uint64_t recordHash(const lookupRecord *record, const char *text) {
+  uint64_t h = mix(record->status ^ (uint64_t)record->classification << 8 ^
+                   (uint64_t)(uint32_t)record->writhe << 16 ^
+                   (uint64_t)record->crossingsRemoved << 48);
+  h = mix(h ^ record->num);
+  h = mix(h ^ record->den);
+  h = mix(h ^ record->mirrorNum);
+  h = mix(h ^ record->mirrorDen);
+  h = mix(h ^ ((uint64_t)record->conwayLength << 32 | record->truncated));
+  for (uint32_t i = 0; i < record->textLength; i++) {
+    h = (h ^ (unsigned char)text[i]) * 0x100000001b3ULL;
+  }
+  return mix(h);
+}
+
+static int sameRecord(const lookupBuilder *builder, const lookupRecord *a, const lookupRecord *b,
+                      const char *bText) {
+  return a->status == b->status && a->classification == b->classification &&
+         a->writhe == b->writhe && a->crossingsRemoved == b->crossingsRemoved &&
+         a->num == b->num && a->den == b->den && a->mirrorNum == b->mirrorNum &&
+         a->mirrorDen == b->mirrorDen && a->conwayLength == b->conwayLength &&
+         a->truncated == b->truncated && a->textLength == b->textLength &&
+         memcmp(builder->text + a->textOffset, bText, b->textLength) == 0;
+}
+
+/* Slot of recordSet holding a record equal to record, or the empty slot where it would go */
+static uint64_t recordSetSlot(const lookupBuilder *builder, const lookupRecord *record,
+                              const char *text, uint64_t hash) {
+  uint64_t mask = builder->recordSetSize - 1;
+  uint64_t i = hash & mask;
+  while (builder->recordSet[i] != 0 &&
+         !sameRecord(builder, &builder->records[builder->recordSet[i] - 1], record, text)) {
+    i = (i + 1) & mask;
+  }
+  return i;
+}
+
+/* Doubles whichever set is half full, rehashing what it holds */
+static int growSets(lookupBuilder *builder) {
+  if (2 * (builder->keyCount + 1) > builder->keySetSize) {
+    uint64_t *old = builder->keySet;
+    builder->keySet = calloc(2 * builder->keySetSize, sizeof(uint64_t));
+    if (builder->keySet == NULL) {
+      builder->keySet = old;
+      return -1;
+    }
+    free(old);
+    builder->keySetSize *= 2;
+    for (uint64_t k = 0; k < builder->keyCount; k++) {
+      builder->keySet[keySetSlot(builder, builder->keys[k].key)] = k + 1;
+    }
+  }
+  if (2 * (builder->recordCount + 1) > builder->recordSetSize) {
+    uint64_t *old = builder->recordSet;
+    builder->recordSet = calloc(2 * builder->recordSetSize, sizeof(uint64_t));
+    if (builder->recordSet == NULL) {
+      builder->recordSet = old;
+      return -1;
+    }
+    free(old);
+    builder->recordSetSize *= 2;
+    for (uint64_t r = 0; r < builder->recordCount; r++) {
+      const lookupRecord *record = &builder->records[r];
+      const char *text = builder->text + record->textOffset;
+      builder->recordSet[recordSetSlot(builder, record, text, recordHash(record, text))] = r + 1;
+    }
+  }
+  return 0;
+}
+
+/* Makes room for more items of size bytes in *array, doubling it as needed */
+static int reserve(void **array, uint64_t *capacity, uint64_t count, uint64_t more, size_t size) {
+  if (count + more <= *capacity) {
+    return 0;
+  }
+  uint64_t grown = *capacity > 0 ? *capacity : 1024;
+  while (grown < count + more) {
+    grown *= 2;
+  }
+  void *bigger = realloc(*array, grown * size);
+  if (bigger == NULL) {
+    return -1;
+  }
+  *array = bigger;
+  *capacity = grown;
+  return 0;
+}
+
+/*
+  Adds key with its result, unless key is already there. Results that are
+  the same in every field share one record. Returns 0, or -1 with errno set
+  when memory ran out, or to EINVAL when the record would not give back the
+  same result.
+*/
+int lookupAdd(lookupBuilder *builder, const uint64_t key[2], const tangleResult *result) {
+  lookupRecord record;
+  tangleResult check;
+
+  if (lookupContains(builder, key)) {
+    return 0;
+  }
+  memset(&record, 0, sizeof(record));
+  record.status = result->status;
+  record.classification = result->classification;
+  record.writhe = result->writhe;
+  record.crossingsRemoved = result->crossingsRemoved;
+  record.num = result->num;
+  record.den = result->den;
+  record.mirrorNum = result->mirrorNum;
+  record.mirrorDen = result->mirrorDen;
+  record.textLength = result->decompositionLength;
+  record.conwayLength = result->conwayLength;
+  record.truncated = result->truncated;
+  unpackRecord(&record, result->decomposition, &check);
+  if (check.conwayLength != result->conwayLength ||
+      memcmp(check.conway, result->conway, result->conwayLength * sizeof(tangleInt)) != 0) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  if (growSets(builder) != 0 ||
+      reserve((void **)&builder->keys, &builder->keyCapacity, builder->keyCount, 1,
+              sizeof(lookupSlot)) != 0) {
+    return -1;
+  }
+
+  uint64_t hash = recordHash(&record, result->decomposition);
+  uint64_t r = recordSetSlot(builder, &record, result->decomposition, hash);
+  if (builder->recordSet[r] == 0) {
+    if (reserve((void **)&builder->records, &builder->recordCapacity, builder->recordCount, 1,
+                sizeof(lookupRecord)) != 0 ||
+        reserve((void **)&builder->text, &builder->textCapacity, builder->textSize,
+                record.textLength + 1, 1) != 0) {
+      return -1;
+    }
+    record.textOffset = builder->textSize;
+    memcpy(builder->text + builder->textSize, result->decomposition, record.textLength);
+    builder->text[builder->textSize + record.textLength] = 0;
+    builder->textSize += record.textLength + 1;
+    builder->records[builder->recordCount++] = record;
+    builder->recordSet[r] = builder->recordCount;
+  }
+
+  lookupSlot *slot = &builder->keys[builder->keyCount++];
+  slot->key[0] = key[0];
+  slot->key[1] = key[1];
+  slot->record = builder->recordSet[r] - 1;
+  slot->reserved = 0;
+  builder->keySet[keySetSlot(builder, key)] = builder->keyCount;
+  return 0;
+}
+
+void lookupBuilderFree(lookupBuilder *builder) {
+  free(builder->keys);
+  free(builder->keySet);
+  free(builder->records);
+  free(builder->recordSet);
+  free(builder->text);
+}
+
+/*
+  Writes the keys gathered so far to path as a table of every code of up
+  to maxCrossings crossings. The keys are split into buckets, and the
+  buckets, largest first, each take the first displacement that sends all
+  their keys to slots still free; a few slots are left spare so the last
+  buckets find theirs quickly. Returns 0, or -1 with errno set.
+*/
+int lookupWrite(const lookupBuilder *builder, const char *path, int maxCrossings) {
+  lookupHeader header;
+  uint64_t n = builder->keyCount;
+  int status = -1;
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, LOOKUP_MAGIC, 8);
+  header.maxCrossings = maxCrossings;
+  header.resultVersion = CONWAY_RESULT_VERSION;
+  header.keys = n;
+  header.buckets = n / LOOKUP_BUCKET_KEYS + 1;
+  header.slots = n + n / 16 + 1;
+  header.records = builder->recordCount;
+  header.textSize = builder->textSize;
+
+  uint64_t buckets = header.buckets;
+  uint64_t *start = calloc(buckets + 1, sizeof(uint64_t));
+  uint64_t *members = malloc((n + 1) * sizeof(uint64_t));
+  uint64_t *order = malloc((buckets + 1) * sizeof(uint64_t));
+  uint32_t *displace = calloc(buckets, sizeof(uint32_t));
+  uint64_t *taken = calloc(header.slots, sizeof(uint64_t));  // key + 1 sent to each slot
+  FILE *out = NULL;
+  if (start == NULL || members == NULL || order == NULL || displace == NULL || taken == NULL) {
+    goto done;
+  }
+
+  // keys by bucket, then buckets by size, largest first
+  uint64_t largest = 0;
+  for (uint64_t k = 0; k < n; k++) {
+    start[bucketOf(builder->keys[k].key, buckets) + 1]++;
+  }
+  for (uint64_t b = 0; b < buckets; b++) {
+    if (start[b + 1] > largest) {
+      largest = start[b + 1];
+    }
+    start[b + 1] += start[b];
+  }
+  // order holds where each bucket fills up to until it is sorted
+  memcpy(order, start, buckets * sizeof(uint64_t));
+  for (uint64_t k = 0; k < n; k++) {
+    members[order[bucketOf(builder->keys[k].key, buckets)]++] = k;
+  }
+  uint64_t placed = 0;
+  for (uint64_t size = largest; size > 0; size--) {
+    for (uint64_t b = 0; b < buckets; b++) {
+      if (start[b + 1] - start[b] == size) {
+        order[placed++] = b;
+      }
+    }
+  }
+
+  for (uint64_t i = 0; i < placed; i++) {
+    uint64_t b = order[i];
+    uint64_t size = start[b + 1] - start[b];
+    uint64_t slot[size];
+    uint32_t d = 0;
+    while (1) {
+      uint64_t j = 0;
+      for (; j < size; j++) {
+        slot[j] = slotOf(builder->keys[members[start[b] + j]].key, d, header.slots);
+        int clash = taken[slot[j]] != 0;
+        for (uint64_t m = 0; m < j && !clash; m++) {
+          clash = slot[m] == slot[j];
+        }
+        if (clash) {
+          break;
+        }
+      }
+      if (j == size) {
+        break;
+      }
+      if (++d == 0) {
+        errno = EOVERFLOW;  // no displacement fits, which takes far more keys than fit in memory
+        goto done;
+      }
+    }
+    displace[b] = d;
+    for (uint64_t j = 0; j < size; j++) {
+      taken[slot[j]] = members[start[b] + j] + 1;
+    }
+  }
+
+  out = fopen(path, "wb");
+  if (out == NULL) {
+    goto done;
+  }
+  static const char padding[8];
+  size_t displaceSize = buckets * sizeof(uint32_t);
+  int ok = fwrite(&header, sizeof(header), 1, out) == 1 &&
+           fwrite(displace, sizeof(uint32_t), buckets, out) == buckets &&
+           fwrite(padding, 1, ((displaceSize + 7) & ~(size_t)7) - displaceSize, out) ==
+             ((displaceSize + 7) & ~(size_t)7) - displaceSize;
+  for (uint64_t s = 0; s < header.slots && ok; s++) {
+    lookupSlot empty = {{0, 0}, LOOKUP_EMPTY, 0};
+    const lookupSlot *slot = taken[s] != 0 ? &builder->keys[taken[s] - 1] : &empty;
+    ok = fwrite(slot, sizeof(lookupSlot), 1, out) == 1;
+  }
+  ok = ok && fwrite(builder->records, sizeof(lookupRecord), builder->recordCount, out) ==
+               builder->recordCount &&
+       fwrite(builder->text, 1, builder->textSize, out) == builder->textSize;
+  if (fclose(out) == 0 && ok) {
+    status = 0;
+  }
+
+done:
+  free(start);
+  free(members);
+  free(order);
+  free(displace);
+  free(taken);
+  return status;
+}
+
+/*
+  Looks pdCode, a code parsePD accepted, up in its canonical form, taking
+  scratch from the arena. Returns 0 with result filled in, or -1 when the
+  code is not in the table; pdCode is left as it was either way.
+*/
+int lookupPD(const lookupTable *table, int rows, tangleInt pdCode[][7], arena *scratch,
+             tangleResult *result) {
+  if (rows > (int)table->header->maxCrossings) {
+    return -1;
+  }
+  tangleInt canonical[rows][7];
+  uint64_t key[2];
+
+  memcpy(canonical, pdCode, sizeof(canonical));
+  if (canonicalPD(rows, canonical, scratch) != 0) {
+    return -1;
+  }
+  hashPD(rows, canonical, key);
+  const lookupRecord *record = lookupFind(table, key);
+  if (record == NULL) {
+    return -1;
+  }
+  lookupResult(table, record, result);
+  return 0;
+}
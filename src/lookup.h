@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+#include "result.h"
+
+/*
+  Results of every tangle up to a few crossings, worked out ahead of time by
+  tools/buildTable and keyed like the cache and store on the hash of the
+  canonical PD code. The file is mapped read-only: a header, a displacement
+  for each bucket of keys, a slot for each key, the distinct results and the
+  text of their decompositions. The displacement of a key's bucket sends it
+  to its own slot, so a lookup reads exactly one slot.
+*/
+#define LOOKUP_MAGIC "PDCTABL2"
+/* result of a slot no key was sent to */
+#define LOOKUP_EMPTY UINT32_MAX
+
+typedef struct lookupHeader {
+  char magic[8];
+  uint32_t maxCrossings;   // every code of up to this many crossings is in the table
+  uint32_t resultVersion;  // CONWAY_RESULT_VERSION of the build that reduced them
+  uint64_t keys;
+  uint64_t buckets;
+  uint64_t slots;
+  uint64_t records;
+  uint64_t textSize;
+} lookupHeader;
+
+typedef struct lookupSlot {
+  uint64_t key[2];
+  uint32_t record;
+  uint32_t reserved;
+} lookupSlot;
+
+/* A tangleResult without its fixed size text; the Conway vector follows from num/den */
+typedef struct lookupRecord {
+  int32_t status;
+  int32_t classification;
+  int32_t writhe;
+  int32_t crossingsRemoved;
+  int64_t num;
+  int64_t den;
+  int64_t mirrorNum;
+  int64_t mirrorDen;
+  uint64_t textOffset;     // of the decomposition in the text area
+  uint32_t textLength;
+  int32_t conwayLength;
+  int32_t truncated;
+  int32_t reserved;
+} lookupRecord;
+
+typedef struct lookupTable {
+  int fd;
+  char *map;
+  size_t mapSize;
+  const lookupHeader *header;
+  const uint32_t *displace;
+  const lookupSlot *slots;
+  const lookupRecord *records;
+  const char *text;
+} lookupTable;
+
+/* Keys and their results as tools/buildTable gathers them, before lookupWrite */
+typedef struct lookupBuilder {
+  lookupSlot *keys;        // each key and its record, in the order added
+  uint64_t keyCount;
+  uint64_t keyCapacity;
+  uint64_t *keySet;        // index + 1 of the key in each slot, 0 for none
+  uint64_t keySetSize;     // a power of two
+  lookupRecord *records;
+  uint64_t recordCount;
+  uint64_t recordCapacity;
+  uint64_t *recordSet;
+  uint64_t recordSetSize;
+  char *text;
+  uint64_t textSize;
+  uint64_t textCapacity;
+} lookupBuilder;
+
+int lookupOpen(lookupTable *table, const char *path);
+void lookupPerror(const char *path);
+const lookupRecord *lookupFind(const lookupTable *table, const uint64_t key[2]);
+void lookupResult(const lookupTable *table, const lookupRecord *record, tangleResult *result);
+int lookupPD(const lookupTable *table, int rows, tangleInt pdCode[][7], arena *scratch,
+             tangleResult *result);
+void lookupClose(lookupTable *table);
+
+int lookupBuilderInit(lookupBuilder *builder);
+int lookupContains(const lookupBuilder *builder, const uint64_t key[2]);
+int lookupAdd(lookupBuilder *builder, const uint64_t key[2], const tangleResult *result);
+int lookupWrite(const lookupBuilder *builder, const char *path, int maxCrossings);
+void lookupBuilderFree(lookupBuilder *builder);
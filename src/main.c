@@ -0,0 +1,235 @@
+#include "parse.h"
+#include "batch.h"
+#include "generate.h"
+#include "lookup.h"
+#include "output.h"
+#include "sweep.h"
+#include "trace.h"
+#include "pdToConwayTangles.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+int main(int argc, char *argv[]) {
+  int batch = 0;
+  int cacheResults = 0;
+  const char *tablePath = NULL;
+  const char *storePath = NULL;
+  const char *statsPath = NULL;
+  const char *tracePath = NULL;
+  int format = FORMAT_CSV;
+  int generate = 0;
+  int sweep = 0;
+  const char *vectorText = NULL;
+  const char *expressionText = NULL;
+  int threads = sysconf(_SC_NPROCESSORS_ONLN);
+  int opt;
+
+  while ((opt = getopt(argc, argv, "a:bce:f:g:j:r:s:S:t:T:")) != -1) {
+    switch (opt) {
+    case 'a':
+      sweep = atoi(optarg);
+      break;
+    case 'b':
+      batch = 1;
+      break;
+    case 'c':
+      cacheResults = 1;
+      break;
+    case 'e':
+      expressionText = optarg;
+      break;
+    case 'f':
+      format = outputFormatNamed(optarg);
+      if (format < 0) {
+        fprintf(stderr, "%s: -f takes csv, json or binary\n", argv[0]);
+        return 1;
+      }
+      break;
+    case 's':
+      storePath = optarg;
+      break;
+    case 'S':
+      statsPath = optarg;
+      break;
+    case 't':
+      tablePath = optarg;
+      break;
+    case 'T':
+      tracePath = optarg;
+      break;
+    case 'j':
+      threads = atoi(optarg);
+      break;
+    case 'g':
+      generate = atoi(optarg);
+      break;
+    case 'r':
+      vectorText = optarg;
+      break;
+    default:
+      fprintf(stderr, "usage: %s [-t table] [-T trace] PD | -b [-f csv|json|binary] [-t table] [-c] [-s store] [-S stats.json] [-T trace] [-j threads] [file|-]"
+              " | -g crossings | -r \"a b c\" | -e \"[a b]+[c]\" | -a crossings\n", argv[0]);
+      return 1;
+    }
+  }
+  if (threads < 1) threads = 1;
+
+  //-g writes every rational tangle up to a number of crossings, -r the one of a Conway vector
+  if (generate > 0) {
+    long records = generateRational(stdout, generate);
+    if (records < 0) {
+      perror("generateRational");
+      return 1;
+    }
+    return 0;
+  }
+  if (vectorText != NULL) {
+    int length = 0;
+    int vector[strlen(vectorText) / 2 + 1];
+    char *end;
+    for (const char *c = vectorText; *c != 0; c++) {
+      long term = strtol(c, &end, 10);
+      if (end != c) {
+        vector[length++] = term;
+        c = end - 1;
+      }
+    }
+    if (generateVector(stdout, vector, length) != 0) {
+      fprintf(stderr, "%s: no crossings in %s\n", argv[0], vectorText);
+      return 1;
+    }
+    return 0;
+  }
+
+  //-e writes the tangle of a sum/product expression as -a names them
+  if (expressionText != NULL) {
+    if (generateExpression(stdout, expressionText) != 0) {
+      fprintf(stderr, "%s: not a tangle expression: %s\n", argv[0], expressionText);
+      return 1;
+    }
+    return 0;
+  }
+
+  //-a reduces every algebraic tangle up to a number of crossings without writing them out
+  if (sweep > 0) {
+    return runSweep(sweep);
+  }
+
+  //-T records the reductions into a ring per thread and saves it for tools/traceDecode
+#ifndef CONWAY_TRACE
+  if (tracePath != NULL) {
+    fprintf(stderr, "%s: -T needs a build with tracing, make clean && make TRACE=1\n", argv[0]);
+    return 1;
+  }
+#endif
+  FILE *traceOut = NULL;
+  if (tracePath != NULL && (traceOut = fopen(tracePath, "wb")) == NULL) {
+    perror(tracePath);
+    return 1;
+  }
+
+  //Batch mode reads pdCodes.txt style records from a file, or stdin if none given
+  //-t looks small tangles up in a table from tools/buildTable before reducing anything,
+  //-c reduces canonical forms and reuses the results of isomorphic tangles,
+  //-s also keeps them in a store on disk for later runs
+  //-f picks the format of the records, see output.h
+  //-S writes the stats of each reduction as JSON lines, in a build with STATS=1
+  if (batch) {
+    FILE *in = stdin;
+    FILE *statsOut = NULL;
+#ifndef CONWAY_STATS
+    if (statsPath != NULL) {
+      fprintf(stderr, "%s: -S needs a build with stats, make clean && make STATS=1\n", argv[0]);
+      return 1;
+    }
+#endif
+    if (optind < argc && strcmp(argv[optind], "-") != 0) {
+      in = fopen(argv[optind], "r");
+      if (in == NULL) {
+        perror(argv[optind]);
+        return 1;
+      }
+    }
+    if (statsPath != NULL && (statsOut = fopen(statsPath, "w")) == NULL) {
+      perror(statsPath);
+      return 1;
+    }
+    int status = runBatch(in, threads, format, tablePath, cacheResults, storePath, statsOut,
+                          traceOut);
+    if (in != stdin) {
+      fclose(in);
+    }
+    if (statsOut != NULL) {
+      fclose(statsOut);
+    }
+    if (traceOut != NULL) {
+      fclose(traceOut);
+    }
+    return status;
+  }
+  if (optind >= argc) return 1;
+  
+  size_t length = strlen(argv[optind]);
+  int capacity = length / 9 + 1;
+  tangleInt (*pdCode)[7] = malloc(capacity * sizeof(*pdCode));
+  if (pdCode == NULL) {
+    perror(argv[0]);
+    return 1;
+  }
+  int row;
+  int status = parsePD(argv[optind], length, pdCode, capacity, &row);
+  if (status != PARSE_OK) {
+    fprintf(stderr, "%s: %s\n", argv[0], parseErrorString(status));
+    free(pdCode);
+    return 1;
+  }
+  //The seventh column stores operation so that
+  //tangle i connects to tangle i+1 by operation pdCode[i][6]
+  //operations are -1 = *, 0 = ?, 1 = +.
+
+  //-t answers a small tangle from the table without reducing it, unless it is being traced
+  if (tablePath != NULL && traceOut == NULL) {
+    lookupTable table;
+    tangleResult result;
+    arena scratch;
+    if (lookupOpen(&table, tablePath) != 0) {
+      lookupPerror(tablePath);
+      free(pdCode);
+      return 1;
+    }
+    arenaInit(&scratch);
+    int found = lookupPD(&table, row, pdCode, &scratch, &result) == 0;
+    if (found) {
+      printResult(stdout, &result);
+    }
+    arenaFree(&scratch);
+    lookupClose(&table);
+    if (found) {
+      free(pdCode);
+      return 0;
+    }
+  }
+
+  traceRing ring;
+  if (traceOut != NULL) {
+    if (traceInit(&ring) != 0) {
+      perror("traceInit");
+      free(pdCode);
+      fclose(traceOut);
+      return 1;
+    }
+    TRACE_ATTACH(&ring);
+  }
+  pdToConway(row, pdCode);
+  free(pdCode);
+  if (traceOut != NULL) {
+    TRACE_ATTACH(NULL);
+    if (traceWrite(traceOut, &ring, 1) != 0) {
+      perror(tracePath);
+    }
+    traceFree(&ring);
+    fclose(traceOut);
+  }
+}
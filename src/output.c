@@ -0,0 +1,188 @@
+#include "output.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *statusNames[] = {
+  "ok", "not Montesinos", "not algebraic", "unresolved", "overflow", "no memory",
+  "not coprime"
+};
+static const char *classNames[] = {
+  "unclassified", "rational", "Montesinos", "algebraic", "non-algebraic"
+};
+
+/* What a tangleClass is called in JSON output */
+const char *className(int classification) {
+  return classNames[classification];
+}
+
+/* The format called name, or -1 */
+int outputFormatNamed(const char *name) {
+  static const char *names[] = {"csv", "json", "binary"};
+  for (int f = 0; f < 3; f++) {
+    if (strcmp(name, names[f]) == 0) {
+      return f;
+    }
+  }
+  return -1;
+}
+
+/* What goes before the first record */
+void writeHeader(FILE *out, int format) {
+  if (format == FORMAT_BINARY) {
+    binaryHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BINARY_MAGIC, 8);
+    header.recordSize = sizeof(binaryRecord);
+    fwrite(&header, sizeof(header), 1, out);
+  }
+}
+
+/* text[0..length) as a JSON string */
+static void jsonString(FILE *out, const char *text, int length) {
+  putc('"', out);
+  for (const char *c = text; c < text + length; c++) {
+    if (*c == '"' || *c == '\\') {
+      putc('\\', out);
+      putc(*c, out);
+    } else if ((unsigned char)*c < 0x20) {
+      fprintf(out, "\\u%04x", *c);
+    } else {
+      putc(*c, out);
+    }
+  }
+  putc('"', out);
+}
+
+/*
+  The decomposition text keeps the line break and trailing commas of its CSV
+  layout; the other formats store it without them.
+*/
+static const char *trimText(const char *text, int *length) {
+  while (*text == '\n' || *text == ' ') {
+    text++;
+  }
+  int n = strlen(text);
+  while (n > 0 && (text[n - 1] == ',' || text[n - 1] == '\n' || text[n - 1] == ' ')) {
+    n--;
+  }
+  *length = n;
+  return text;
+}
+
+static void copyField(char *field, size_t size, const char *text) {
+  memset(field, 0, size);
+  size_t length = strlen(text);
+  memcpy(field, text, length < size ? length : size - 1);
+}
+
+/* Names the input a result is for: its line, twist and fraction */
+void writePrefix(FILE *out, int format, long line, const char *twist, const char *frac) {
+  switch (format) {
+  case FORMAT_CSV:
+    fprintf(out, "%s,%s,", twist, frac);
+    break;
+  case FORMAT_JSON:
+    fprintf(out, "{\"line\":%ld,\"twist\":", line);
+    jsonString(out, twist, strlen(twist));
+    fputs(",\"frac\":", out);
+    jsonString(out, frac, strlen(frac));
+    putc(',', out);
+    break;
+  case FORMAT_BINARY: {
+    binaryRecord record;
+    record.line = line;
+    copyField(record.twist, sizeof(record.twist), twist);
+    copyField(record.frac, sizeof(record.frac), frac);
+    fwrite(&record, offsetof(binaryRecord, status), 1, out);
+    break;
+  }
+  }
+}
+
+static void writeBinary(FILE *out, int status, const tangleResult *result, const char *text) {
+  binaryRecord record;
+
+  memset(&record, 0, sizeof(record));
+  record.status = status;
+  if (result != NULL) {
+    record.classification = result->classification;
+    record.writhe = result->writhe;
+    record.truncated = result->truncated;
+    record.num = result->num;
+    record.den = result->den;
+    record.mirrorNum = result->mirrorNum;
+    record.mirrorDen = result->mirrorDen;
+  }
+  int length;
+  text = trimText(text, &length);
+  if (length >= BINARY_TEXT) {
+    length = BINARY_TEXT - 1;
+    record.truncated = 1;
+  }
+  memcpy(record.text, text, length);
+  fwrite(&record.status, sizeof(record) - offsetof(binaryRecord, status), 1, out);
+}
+
+/* The rest of the record after writePrefix, ending the line in the text formats */
+void writeResult(FILE *out, int format, const tangleResult *result) {
+  char conway[CONWAY_TEXT_MAX];
+  char fraction[2 * FRACTION_TEXT_MAX + 2];
+  int rational = result->status == CONWAY_OK && result->classification == TANGLE_RATIONAL;
+
+  if (rational) {
+    formatResultConway(conway, CONWAY_TEXT_MAX, result);
+  }
+  switch (format) {
+  case FORMAT_CSV:
+    printResult(out, result);
+    fputs(";\n", out);
+    break;
+  case FORMAT_JSON:
+    fprintf(out, "\"writhe\":%d,\"status\":\"%s\",\"class\":\"%s\"", result->writhe,
+            statusNames[result->status], classNames[result->classification]);
+    if (rational) {
+      formatFraction(fraction, sizeof(fraction), result, 0);
+      fprintf(out, ",\"fraction\":\"%s\",\"conway\":[", fraction);
+      for (int i = 0; i < result->conwayLength; i++) {
+        fprintf(out, i == 0 ? "%lld" : ",%lld", result->conway[i]);
+      }
+      formatFraction(fraction, sizeof(fraction), result, 1);
+      fprintf(out, "],\"mirror\":\"%s\"", fraction);
+    } else if (result->status != CONWAY_OVERFLOW && result->status != CONWAY_NO_MEMORY &&
+               result->status != CONWAY_NOT_COPRIME) {
+      int length;
+      const char *text = trimText(result->decomposition, &length);
+      fputs(",\"decomposition\":", out);
+      jsonString(out, text, length);
+    }
+    if (result->crossingsRemoved > 0) {
+      fprintf(out, ",\"crossingsRemoved\":%d", result->crossingsRemoved);
+    }
+    if (result->truncated) {
+      fputs(",\"truncated\":true", out);
+    }
+    fputs("}\n", out);
+    break;
+  case FORMAT_BINARY:
+    writeBinary(out, result->status, result, rational ? conway : result->decomposition);
+    break;
+  }
+}
+
+/* writeResult for a record whose PD code did not parse */
+void writeParseError(FILE *out, int format, const char *message) {
+  switch (format) {
+  case FORMAT_CSV:
+    fprintf(out, "Parse error: %s,;\n", message);
+    break;
+  case FORMAT_JSON:
+    fputs("\"status\":\"parse error\",\"error\":", out);
+    jsonString(out, message, strlen(message));
+    fputs("}\n", out);
+    break;
+  case FORMAT_BINARY:
+    writeBinary(out, RECORD_PARSE_ERROR, NULL, message);
+    break;
+  }
+}
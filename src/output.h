@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include "result.h"
+
+/*
+  The formats batch mode writes its records in. Every record is a prefix
+  naming the input, then the result, so a cached result can follow any
+  prefix:
+
+    csv     twist,frac, then what printResult writes and ";"
+    json    one object per line
+    binary  a binaryHeader, then one binaryRecord per record
+*/
+enum outputFormat {
+  FORMAT_CSV = 0,
+  FORMAT_JSON,
+  FORMAT_BINARY
+};
+
+#define BINARY_MAGIC "PDCRECS1"
+#define BINARY_TEXT 400
+/* status of a record whose PD code did not parse, its message in text */
+#define RECORD_PARSE_ERROR -1
+
+typedef struct binaryHeader {
+  char magic[8];
+  uint32_t recordSize;
+  uint32_t reserved;
+} binaryHeader;
+
+/*
+  A fixed width record, so record i of a file is at
+  sizeof(binaryHeader) + i * sizeof(binaryRecord). Strings are NUL padded;
+  twist and frac are cut to fit. text is the Conway vector of a rational
+  tangle or the decomposition of any other, with truncated set when it did
+  not fit. A rational tangle whose fraction is past 64 bits has num, den and
+  their mirror 0, and its Conway vector in text gives the fraction.
+*/
+typedef struct binaryRecord {
+  int64_t line;          // of the input, from 1
+  char twist[16];
+  char frac[40];
+  // the result, from here on
+  int32_t status;        // an enum conwayStatus, or RECORD_PARSE_ERROR
+  int32_t classification;
+  int32_t writhe;
+  int32_t truncated;
+  int64_t num;           // fraction of a rational tangle, and its mirror
+  int64_t den;
+  int64_t mirrorNum;
+  int64_t mirrorDen;
+  char text[BINARY_TEXT];
+} binaryRecord;
+
+_Static_assert(sizeof(binaryRecord) == 512, "binaryRecord is 512 bytes");
+
+int outputFormatNamed(const char *name);
+const char *className(int classification);
+void writeHeader(FILE *out, int format);
+void writePrefix(FILE *out, int format, long line, const char *twist, const char *frac);
+void writeResult(FILE *out, int format, const tangleResult *result);
+void writeParseError(FILE *out, int format, const char *message);
@@ -1,62 +1,169 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <stdio.h>
+#include "parse.h"
 #include "util.h"
 
-int (* parse(char* input, int* rows))[7] {
-  DEBUG_PRINTF("Got input: %s\n", input);
-  *rows = -1;
-  const int cols = 7;
-  char *c = input;
-
-  while (*c != 0) {
-    if (*c == '(' || *c == '[' || *c == '{')
-      (*rows)++;
-    c++;
+const char *parseErrorString(int status) {
+  switch (status) {
+  case PARSE_OK:
+    return "ok";
+  case PARSE_EMPTY:
+    return "PD code has no crossings";
+  case PARSE_BAD_CHARACTER:
+    return "unexpected character in PD code";
+  case PARSE_BRACKETS:
+    return "unbalanced brackets or label outside a crossing";
+  case PARSE_ARITY:
+    return "crossing without exactly 4 arcs";
+  case PARSE_TOO_LARGE:
+    return "more crossings than the buffer holds";
+  case PARSE_LABEL_RANGE:
+    return "arc label outside 1..2n+2";
+  case PARSE_LABEL_COUNT:
+    return "arc labels are not 4 ends and 2n-2 arcs seen twice";
   }
+  return "unknown parse error";
+}
 
-  DEBUG_PRINTF("Allocating %d rows and %d cols", *rows, 7);
+/*
+  Every label must be in 1..2*rows+2, at most twice, and exactly four labels
+  (the ends of the tangle) appear once; counting 4*rows slots this also makes
+  the labels contiguous. Columns 4-6 are not filled yet and give 3*rows
+  counters, enough for the 2*rows+2 labels once there are two crossings.
+*/
+static int checkLabels(int rows, tangleInt matrix[][7]) {
+  int ends = 0;
 
-  int (*matrix)[7] = malloc(*rows * 7 * sizeof(int));
+  if (rows == 1) {
+    for (int i = 0; i < 4; i++) {
+      for (int j = 0; j < i; j++) {
+        if (matrix[0][i] == matrix[0][j])
+          return PARSE_LABEL_COUNT;
+      }
+    }
+    return PARSE_OK;
+  }
 
-  DEBUG_PRINTF("....done\n");
+  for (int i = 0; i < rows; i++) {
+    matrix[i][4] = matrix[i][5] = matrix[i][6] = 0;
+  }
+  for (int i = 0; i < rows; i++) {
+    for (int j = 0; j < 4; j++) {
+      tangleInt label = matrix[i][j];
+      if (++matrix[label / 3][4 + label % 3] > 2)
+        return PARSE_LABEL_COUNT;
+    }
+  }
+  for (int label = 0; label < 2 * rows + 2; label++) {
+    if (matrix[label / 3][4 + label % 3] == 1)
+      ends++;
+  }
+  return ends == 4 ? PARSE_OK : PARSE_LABEL_COUNT;
+}
 
+/*
+  Reads the PD code in input[0..length) into matrix, which has room for
+  capacity rows; length / 9 + 1 rows always suffice, since each crossing takes
+  at least "[a,b,c,d]". The code is read in one pass without allocating.
+  Whitespace and commas separate labels, any of [({ opens and any of ])}
+  closes a bracket, and labels sit two brackets deep, four to a crossing.
+  Labels are stored from 0 and each row gets the fraction -1/1. Returns
+  PARSE_OK and sets *rows, or one of the other parseStatus values.
+*/
+int parsePD(const char *input, size_t length, tangleInt matrix[][7], int capacity, int *rows) {
+  const char *c = input;
+  const char *end = input + length;
+  int depth = 0;
   int row = 0;
   int col = 0;
+  tangleInt maxLabel = 0;
 
-  for( c = input; *c != 0; c++ ) {
-
-    if (col == 4) {
-      /* Currently working under the biological convention*/
-      matrix[row][4] = -1;
-      /*
-       * Un-comment when working under the mathematical convention
-       * matrix[row][4] = 1;
-      */
-      matrix[row][5] = 1;
-      matrix[row][6] = 0;
-      row++;
-      col=0;
+  *rows = 0;
+  while (c < end) {
+    char ch = *c;
+
+    if (ch >= '0' && ch <= '9') {
+      if (depth != 2)
+        return PARSE_BRACKETS;
+      if (col == 4)
+        return PARSE_ARITY;
+      if (row == capacity)
+        return PARSE_TOO_LARGE;
+      tangleInt label = 0;
+      while (c < end && *c >= '0' && *c <= '9') {
+        label = label * 10 + (*c - '0');
+        // no tangle that fits in capacity rows has labels this large
+        if (label > 2 * (tangleInt)capacity + 2)
+          return PARSE_LABEL_RANGE;
+        c++;
+      }
+      if (label == 0)
+        return PARSE_LABEL_RANGE;
+      if (label > maxLabel)
+        maxLabel = label;
+      matrix[row][col++] = label - 1;
       continue;
     }
 
-    if ( *c <= '9' && *c >= '0') {
-      matrix[row][col] = strtol(c, &c, 10) - 1;
-      col++;
+    switch (ch) {
+    case ' ': case '\t': case '\n': case '\r': case ',':
+      break;
+    case '[': case '(': case '{':
+      if (++depth > 2)
+        return PARSE_BRACKETS;
+      break;
+    case ']': case ')': case '}':
+      if (depth == 0)
+        return PARSE_BRACKETS;
+      if (depth-- == 2) {
+        if (col != 4)
+          return PARSE_ARITY;
+        row++;
+        col = 0;
+      }
+      break;
+    case 0:
+      // a string shorter than length
+      end = c;
       continue;
+    default:
+      return PARSE_BAD_CHARACTER;
     }
+    c++;
   }
 
+  if (depth != 0)
+    return PARSE_BRACKETS;
+  if (row == 0)
+    return PARSE_EMPTY;
+  if (maxLabel > 2 * (tangleInt)row + 2)
+    return PARSE_LABEL_RANGE;
+  int status = checkLabels(row, matrix);
+  if (status != PARSE_OK)
+    return status;
+
+  for (int i = 0; i < row; i++) {
+    /* Currently working under the biological convention*/
+    matrix[i][4] = -1;
+    /*
+     * Un-comment when working under the mathematical convention
+     * matrix[i][4] = 1;
+    */
+    matrix[i][5] = 1;
+    matrix[i][6] = 0;
+  }
+  *rows = row;
+
 #ifdef DEBUG
   printf("DEBUG:\n");
-  for (int i = 0; i < *rows; i++){
+  for (int i = 0; i < row; i++){
     for (int j = 0; j < 6; j++){
-      printf("%d\t", matrix[i][j]);
+      printf("%lld\t", matrix[i][j]);
     }
     printf("\n");
   }
   printf("\n");
 #endif
-
-  return matrix;
+  return PARSE_OK;
 }
@@ -1,3 +1,19 @@
 #pragma once
 
-int (* parse(char* input, int* rows))[7];
+#include <stddef.h>
+#include "fraction.h"
+
+/* Status returned by parsePD */
+enum parseStatus {
+  PARSE_OK = 0,
+  PARSE_EMPTY,          // no crossings
+  PARSE_BAD_CHARACTER,  // something other than labels, brackets, commas and whitespace
+  PARSE_BRACKETS,       // unbalanced, nested too deep, or a label outside a crossing
+  PARSE_ARITY,          // a crossing without exactly 4 labels
+  PARSE_TOO_LARGE,      // more crossings than the caller's buffer holds
+  PARSE_LABEL_RANGE,    // a label outside 1..2n+2
+  PARSE_LABEL_COUNT     // labels are not 4 tangle ends plus 2n-2 arcs seen twice
+};
+
+int parsePD(const char *input, size_t length, tangleInt matrix[][7], int capacity, int *rows);
+const char *parseErrorString(int status);
@@ -1,9 +1,12 @@
 #include "util.h"
-#include "parse.h"
+#include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include "pdToConwayTangles.h"
+#include "bigint.h"
+#include "simplify.h"
+#include "trace.h"
 /***************************************************************************************
   Authors: Isabel Darcy, Ethan Rooke, Zachary Bryhtan
   Last Modified: 4-17-2023
@@ -46,7 +49,8 @@
  columns 1 and 3 indicate if edge corresponds to
  a = 0, b =1, c = 2, d = 3, respectively. */
 
-void createEdge(int r, int pdCode[r][7], int edge[2 * r + 2][4]) {
+void createEdge(int r, tangleInt pdCode[r][7], int edge[2 * r + 2][4]) {
+  STAT_ADD(edgeRowsScanned, 2 * r + 2);
   for (int i = 0; i < 2 * r + 2; i++){
     for(int j = 0; j < 4; j++){
       edge[i][j] = -9;
@@ -65,31 +69,87 @@ void createEdge(int r, int pdCode[r][7], int edge[2 * r + 2][4]) {
   }
 }
 
-void swapTanglesAB(int TangleA, int TangleB, int newRow, int pdCode[][7], int row, int edge[][4]){
-  int temp[7];
-  for(int i = 0; i < 7; i++){
-    temp[i] = pdCode[TangleA][i];
-    pdCode[TangleA][i] = pdCode[TangleB][i];
-    pdCode[TangleB][i] = temp[i];
+/*
+  The four arcs of a tangle are always its own pdCode row, so the row is the
+  index from a tangle to its entries in edge. Relabelling a tangle only has to
+  visit those arcs instead of scanning all of edge. An arc that leaves and
+  re-enters the same tangle appears twice in the row and is only visited once.
+*/
+static int firstArcInRow(int Tangle, int Clock, tangleInt pdCode[][7]){
+  for(int i = 0; i < Clock; i++){
+    if(pdCode[Tangle][i] == pdCode[Tangle][Clock]){
+      return 0;
+    }
   }
+  return 1;
+}
 
-  for(int i = 0; i < 2*row; i++){
-    if(edge[i][0]==TangleA){
-      edge[i][0] = TangleB;
-    }else if (edge[i][0]==TangleB){
-      edge[i][0] = TangleA;
+/* Adds shift to the clock at which each of Tangle's arcs attaches to Tangle */
+static void moveTangleClocks(int Tangle, int shift, tangleInt pdCode[][7], int edge[][4]){
+  for(int i = 0; i < 4; i++){
+    if(!firstArcInRow(Tangle, i, pdCode)){
+      continue;
     }
-    if(edge[i][2]==TangleA){
-      edge[i][2] = TangleB;
-    }else if (edge[i][2]==TangleB){
-      edge[i][2] = TangleA;
+    int Arc = pdCode[Tangle][i];
+    STAT_ADD(edgeRowsScanned, 1);
+    if(edge[Arc][0] == Tangle){
+      edge[Arc][1] = (edge[Arc][1] + shift)%4;
+    }
+    if(edge[Arc][2] == Tangle){
+      edge[Arc][3] = (edge[Arc][3] + shift)%4;
     }
   }
 }
 
+void shiftTangleClocks(int Tangle, int shift, tangleInt pdCode[][7], int edge[][4]){
+  //every turn of a tangle's arcs ends here, or in turnTangle
+  if(shift % 4 != 0){
+    STAT_ADD(rotations, 1);
+    TRACE(TRACE_ROTATE, Tangle, -1, shift % 4, -1, pdCode[Tangle][4], pdCode[Tangle][5]);
+  }
+  moveTangleClocks(Tangle, shift, pdCode, edge);
+}
+
+/* Rows TangleA and TangleB have traded places, exchange them in edge */
+static void swapTangleArcs(int TangleA, int TangleB, tangleInt pdCode[][7], int edge[][4]){
+  int tangles[2] = {TangleA, TangleB};
+
+  STAT_ADD(tangleSwaps, 1);
+  TRACE(TRACE_SWAP, TangleA, TangleB, -1, -1, 0, 0);
+  for(int t = 0; t < 2; t++){
+    for(int i = 0; i < 4; i++){
+      int Arc = pdCode[tangles[t]][i];
+      //Arcs shared with TangleA were already exchanged
+      if(!firstArcInRow(tangles[t], i, pdCode) || (t == 1 &&
+         (Arc == pdCode[TangleA][0] || Arc == pdCode[TangleA][1] ||
+          Arc == pdCode[TangleA][2] || Arc == pdCode[TangleA][3]))){
+        continue;
+      }
+      STAT_ADD(edgeRowsScanned, 1);
+      for(int end = 0; end < 4; end += 2){
+        if(edge[Arc][end] == TangleA){
+          edge[Arc][end] = TangleB;
+        } else if(edge[Arc][end] == TangleB){
+          edge[Arc][end] = TangleA;
+        }
+      }
+    }
+  }
+}
+
+void swapTanglesAB(int TangleA, int TangleB, int newRow, tangleInt pdCode[][7], int row, int edge[][4]){
+  tangleInt temp[7];
+  for(int i = 0; i < 7; i++){
+    temp[i] = pdCode[TangleA][i];
+    pdCode[TangleA][i] = pdCode[TangleB][i];
+    pdCode[TangleB][i] = temp[i];
+  }
+  swapTangleArcs(TangleA, TangleB, pdCode, edge);
+}
+
 /* When a rational tangle a/b is rotated *by 90 degrees*, it becomes -b/a */
-void rotateTangleFraction(int pdCode[][7], int tang) {
-  int temp = pdCode[tang][4];
+void rotateTangleFraction(tangleInt pdCode[][7], int tang) {
+  tangleInt temp = pdCode[tang][4];
   pdCode[tang][4] = -pdCode[tang][5];
   pdCode[tang][5] = temp;
 
@@ -100,9 +160,9 @@ void rotateTangleFraction(int pdCode[][7], int tang) {
 }
 
 /*Rotate the given tangle's PD code row and associtated edge information by 90 degrees CCW N-times*/
-void rotateTangle90CCW_Ntimes(int N, int Tangle, int totalRows, int pdCode[][7], int edge[][4]){
+void rotateTangle90CCW_Ntimes(int N, int Tangle, int totalRows, tangleInt pdCode[][7], int edge[][4]){
   int temp[4] = {};
-  int rotate = (4 - N)%4;
+  int rotate = ((4 - N) % 4 + 4) % 4;
   for(int i = 0; i < 4; i++){
     temp[i] = pdCode[Tangle][i];
   }
@@ -114,16 +174,171 @@ void rotateTangle90CCW_Ntimes(int N, int Tangle, int totalRows, int pdCode[][7],
     rotateTangleFraction(pdCode, Tangle);
   }
 
-  int edgeRotate = N % 4;
-  for(int i = 0; i < 2*totalRows + 2; i++){
-    if(edge[i][0] == Tangle){
-      edge[i][1] = (edge[i][1] + edgeRotate) % 4;
+  shiftTangleClocks(Tangle, N % 4, pdCode, edge);
+
+}
+
+/*
+  The merge sweeps work on a copy of the tangles laid out by column instead
+  of pdCode's rows: the four arcs of a tangle packed 16 bits each into one
+  word, the numerators and denominators in arrays of their own and the turns
+  in bytes. A sweep reads a tangle's arcs, and a neighbour's fraction only
+  once they meet, so it touches 8 bytes a tangle where a row is 56. Tangles
+  with arcs past 16 bits keep theirs in wideArcs instead. The operation
+  column is not read before algTangle and stays in pdCode.
+
+  A tangle is turned by recording it in turns[] instead of moving its arcs.
+  After turns[t] quarter turns counterclockwise, clock c of tangle t is kept
+  in column (c - turns[t]) & 3, and edge goes on holding the column each arc
+  sits in, so a turn writes neither the arcs nor edge. The fraction is
+  turned at once: the merge that follows a turn always reads it.
+  storeTangleTable puts the arcs in the columns of their clocks on the way
+  back to pdCode, before anything reads the rows by clock.
+*/
+#define TABLE_ARC_BITS 16
+
+typedef struct tangleTable {
+  uint64_t *arcs;       // arc in column c of tangle t in bits 16c to 16c + 15
+  int (*wideArcs)[4];   // the arcs by column when a label needs more than 16 bits, else NULL
+  tangleInt *num;
+  tangleInt *den;       // 0/0 for a tangle absorbed by another
+  unsigned char *turns;
+} tangleTable;
+
+/* Bytes of scratch a tangleTable of rows tangles takes, for either layout */
+static size_t tangleTableSize(int rows){
+  size_t arcs = 2 * rows + 2 <= 1 << TABLE_ARC_BITS ? sizeof(uint64_t) : 4 * sizeof(int);
+  return (size_t)rows * (arcs + 2 * sizeof(tangleInt) + 1);
+}
+
+static inline int tableArc(const tangleTable *table, int Tangle, int column){
+  if(table->wideArcs == NULL){
+    return (int)(table->arcs[Tangle] >> (TABLE_ARC_BITS * column) & 0xffff);
+  }
+  return table->wideArcs[Tangle][column];
+}
+
+static inline void setTableArc(tangleTable *table, int Tangle, int column, int Arc){
+  if(table->wideArcs == NULL){
+    int shift = TABLE_ARC_BITS * column;
+    table->arcs[Tangle] = (table->arcs[Tangle] & ~((uint64_t)0xffff << shift)) | (uint64_t)Arc << shift;
+    return;
+  }
+  table->wideArcs[Tangle][column] = Arc;
+}
+
+static inline int tableRemoved(const tangleTable *table, int Tangle){
+  return table->num[Tangle] == 0 && table->den[Tangle] == 0;
+}
+
+/* Copies the arcs and fractions of pdCode's rows into a table taken from scratch. Returns 0, or -1 when scratch ran out */
+static int loadTangleTable(int rows, tangleInt pdCode[][7], tangleTable *table, arena *scratch){
+  table->arcs = NULL;
+  table->wideArcs = NULL;
+  if(2 * rows + 2 <= 1 << TABLE_ARC_BITS){
+    table->arcs = arenaAlloc(scratch, rows * sizeof(uint64_t));
+  } else {
+    table->wideArcs = arenaAlloc(scratch, rows * sizeof(*table->wideArcs));
+  }
+  table->num = arenaAlloc(scratch, rows * sizeof(tangleInt));
+  table->den = arenaAlloc(scratch, rows * sizeof(tangleInt));
+  table->turns = arenaAlloc(scratch, rows);
+  if((table->arcs == NULL && table->wideArcs == NULL) || table->num == NULL ||
+     table->den == NULL || table->turns == NULL){
+    return -1;
+  }
+  for(int t = 0; t < rows; t++){
+    if(table->arcs != NULL){
+      table->arcs[t] = 0;
+    }
+    for(int i = 0; i < 4; i++){
+      setTableArc(table, t, i, pdCode[t][i]);
+    }
+    table->num[t] = pdCode[t][4];
+    table->den[t] = pdCode[t][5];
+    table->turns[t] = 0;
+  }
+  return 0;
+}
+
+/*
+  Writes the table back over pdCode, each live tangle's arcs in the columns
+  of its clocks with edge moved to match, and each absorbed tangle's row
+  zeroed.
+*/
+static void storeTangleTable(int rows, tangleInt pdCode[][7], int edge[][4], const tangleTable *table){
+  for(int t = 0; t < rows; t++){
+    if(tableRemoved(table, t)){
+      for(int i = 0; i < 7; i++){
+        pdCode[t][i] = 0;
+      }
+      continue;
+    }
+    for(int i = 0; i < 4; i++){
+      pdCode[t][i] = tableArc(table, t, (i - table->turns[t]) & 3);
     }
-    if(edge[i][2] == Tangle){
-      edge[i][3] = (edge[i][3] + edgeRotate) % 4;
+    pdCode[t][4] = table->num[t];
+    pdCode[t][5] = table->den[t];
+    if(table->turns[t] != 0){
+      moveTangleClocks(t, table->turns[t], pdCode, edge);
     }
   }
+}
 
+static inline int turnedColumn(const tangleTable *table, int Tangle, int Clock){
+  return (Clock - table->turns[Tangle]) & 3;
+}
+
+/* When a rational tangle a/b is rotated *by 90 degrees*, it becomes -b/a */
+static void turnTableFraction(tangleTable *table, int Tangle){
+  tangleInt temp = table->num[Tangle];
+  table->num[Tangle] = -table->den[Tangle];
+  table->den[Tangle] = temp;
+
+  if(table->den[Tangle] < 0){
+    table->num[Tangle] *= -1;
+    table->den[Tangle] *= -1;
+  }
+}
+
+static void turnTangle(int Tangle, int N, tangleTable *table){
+  table->turns[Tangle] = (table->turns[Tangle] + N) & 3;
+  if(N % 2 == 1){
+    turnTableFraction(table, Tangle);
+  }
+  STAT_ADD(rotations, 1);
+  TRACE(TRACE_ROTATE, Tangle, -1, N % 4, -1, table->num[Tangle], table->den[Tangle]);
+}
+
+/* getTangle2 for a tangle table */
+static inline void turnedTangle2(int Tangle, int Clock, int *tangle2, int *tangle2Clock,
+                                 const tangleTable *table, int edge[][4]){
+  int Arc = tableArc(table, Tangle, turnedColumn(table, Tangle, Clock));
+  int end;
+  STAT_ADD(edgeRowsScanned, 1);
+  if (edge[Arc][0] == Tangle) {
+    end = 2;
+  } else if (edge[Arc][2] == Tangle) {
+    end = 0;
+  } else {
+    *tangle2 = -1;
+    *tangle2Clock = -1;
+    return;
+  }
+  *tangle2 = edge[Arc][end];
+  //an end of the tangle has no crossing and no turn
+  *tangle2Clock = *tangle2 < 0 ? edge[Arc][end + 1] : (edge[Arc][end + 1] + table->turns[*tangle2]) & 3;
+}
+
+/* Points the end of Arc in column from of TangleA at column to of TangleB */
+static void moveArcEnd(int Arc, int TangleA, int from, int TangleB, int to, int edge[][4]){
+  for(int end = 0; end < 4; end += 2){
+    if(edge[Arc][end] == TangleA && edge[Arc][end + 1] == from){
+      edge[Arc][end] = TangleB;
+      edge[Arc][end + 1] = to;
+      return;
+    }
+  }
 }
 
 /* Given Tangle and Clock, finds *tangle2 which which shares Arc that attaches
@@ -133,36 +348,26 @@ void rotateTangle90CCW_Ntimes(int N, int Tangle, int totalRows, int pdCode[][7],
  * use the result after the call to the function.*/
 
 void getTangle2(int r, int Tangle, int Clock, int *tangle2, int *tangle2Clock,
-                int pdCode[][7], int edge[][4]) {
+                tangleInt pdCode[][7], int edge[][4]) {
   /* Get the arc label of current tangle through pdCode[Tangle][Clock]
   *  then checks which tangles that arc connect in edge[Arc]
   *  the other tangle index is in the 0, or 2 position followed by the Clock 
   *  position the arc connects through (at position 1 or 3).
   *  We save and change these values in tangle2 and tangle2Clock resp.*/
   int Arc = pdCode[Tangle][Clock];
+  STAT_ADD(edgeRowsScanned, 1);
   if (edge[Arc][0] == Tangle) {
     *tangle2 = edge[Arc][2];
     *tangle2Clock = edge[Arc][3];
   } else if (edge[Arc][2] == Tangle) {
     *tangle2 = edge[Arc][0];
     *tangle2Clock = edge[Arc][1];
-  } else
+  } else {
+    //Arc no longer touches Tangle, report that no tangle was found
+    *tangle2 = -1;
+    *tangle2Clock = -1;
     DEBUG_PRINTF("Tangle = %d, Arc = %d, Arc2 = %d \n", Tangle, edge[Arc][0],
            edge[Arc][2]);
-}
-
-//Returns the integer location of another tangle which can be combined to the given tangle
-//along the clock positions provided. If no such tangle exists, return -1.
-int canCombine(int Tangle, int Clock1, int Clock2, int rows, int pdCode[][7], int edge[][4]){
-  int tangle2i, tangle2ii, tangle2iClock, tangle2iiClock;
-  
-  getTangle2(rows, Tangle, Clock1, &tangle2i, &tangle2iClock, pdCode, edge);
-  getTangle2(rows, Tangle, Clock2, &tangle2ii, &tangle2iiClock, pdCode, edge);
-
-  if (tangle2i == tangle2ii && tangle2i >= 0){
-    return tangle2i;
-  } else {
-    return -1;
   }
 }
 
@@ -189,6 +394,7 @@ void combineTanglesEdge(int r, int Tangle, int tangle2, int Arc,
 */
 
 void ClockEdge(int r, int newTang, int Arc, int Clock, int edge[2 * r + 2][4]) {
+  STAT_ADD(edgeRowsScanned, 1);
   if (edge[Arc][0] == newTang) {
     edge[Arc][1] = Clock;
   } else if (edge[Arc][2] == newTang) {
@@ -199,7 +405,7 @@ void ClockEdge(int r, int newTang, int Arc, int Clock, int edge[2 * r + 2][4]) {
 
 /* places new arcs into pdCode for combined tangle from subroutine addTangles */
 
-void newArcsCombinedTangle(int r, int pdCode[r][7], int newTangle, int arc0,
+void newArcsCombinedTangle(int r, tangleInt pdCode[r][7], int newTangle, int arc0,
                            int arc1, int arc2, int arc3) {
   pdCode[newTangle][0] = arc0;
   pdCode[newTangle][1] = arc1;
@@ -209,31 +415,36 @@ void newArcsCombinedTangle(int r, int pdCode[r][7], int newTangle, int arc0,
 
 //Combines TangleA and TangleB along Clock1 and Clock2 of TangleA, stores result in location of TangleB
 //Typically take TangleB < TangleA
-int combineTanglesPDandEdge(int TangleA, int TangleB, int Clock1, int Clock2, int rows, int pdCode[][7], int edge[][4]){
+static void combineTanglesPDandEdge(int TangleA, int TangleB, int Clock1, int Clock2, tangleTable *table, int edge[][4]){
+  TRACE(TRACE_MERGE, TangleA, TangleB, Clock1, Clock2, table->num[TangleB], table->den[TangleB]);
   int Clock1B = (Clock1 + 3) % 4;
   int Clock2B = (Clock2 + 1) % 4;
+  int column0 = turnedColumn(table, TangleA, Clock1B);
+  int column3 = turnedColumn(table, TangleA, Clock2B);
   
-  int arc0 = pdCode[TangleA][Clock1B];
-  int arc3 = pdCode[TangleA][Clock2B];
-  //Swaps TangleA for TangleB in Arc3 row and Arc0 row of Edge
-  combineTanglesEdge(rows, TangleA, TangleB, arc0, edge);
-  combineTanglesEdge(rows, TangleA, TangleB, arc3, edge);
+  int arc0 = tableArc(table, TangleA, column0);
+  int arc3 = tableArc(table, TangleA, column3);
+  //Moves Arc0 and Arc3 from TangleA's columns for the clocks to TangleB's
+  moveArcEnd(arc0, TangleA, column0, TangleB, turnedColumn(table, TangleB, Clock1B), edge);
+  moveArcEnd(arc3, TangleA, column3, TangleB, turnedColumn(table, TangleB, Clock2B), edge);
   
-  // ClockEdge(rows, TangleB, arc0, Clock1B, edge);
-  // ClockEdge(rows, TangleB, arc3, Clock2B, edge);
-  
-  pdCode[TangleB][Clock1B] = arc0;
-  pdCode[TangleB][Clock2B] = arc3;
+  setTableArc(table, TangleB, turnedColumn(table, TangleB, Clock1B), arc0);
+  setTableArc(table, TangleB, turnedColumn(table, TangleB, Clock2B), arc3);
   
   //Remove absorbed Arcs from Edge
+  int arc1 = tableArc(table, TangleA, turnedColumn(table, TangleA, Clock1));
+  int arc2 = tableArc(table, TangleA, turnedColumn(table, TangleA, Clock2));
   for(int i = 0; i < 4; i++){
-    edge[pdCode[TangleA][Clock1]][i] = -9;
-    edge[pdCode[TangleA][Clock2]][i] = -9;
+    edge[arc1][i] = -9;
+    edge[arc2][i] = -9;
   }
-  //Remove absorbed Tangle from PD
-  for(int i = 0; i < 7; i++){
-    pdCode[TangleA][i] = 0;
+  //Remove absorbed Tangle from the table
+  for(int i = 0; i < 4; i++){
+    setTableArc(table, TangleA, i, 0);
   }
+  table->num[TangleA] = 0;
+  table->den[TangleA] = 0;
+  table->turns[TangleA] = 0;
 }
 
 /* Determines if a Tangle can be added to the input Tangle.
@@ -244,7 +455,7 @@ int combineTanglesPDandEdge(int TangleA, int TangleB, int Clock1, int Clock2, in
    Note 180 degree rotation does not change rational tangles,
    but can change non-rational tangles */
 
-int addTangles(int r, int Tangle, int Clock, int Clock2, int pdCode[][7],
+int addTangles(int r, int Tangle, int Clock, int Clock2, tangleInt pdCode[][7],
                int edge[2 * r+2][4]) {
   
   int temp, j, arc, tangleindex, tangle2i, tangle2ii, tangle2iClock,
@@ -280,7 +491,7 @@ int addTangles(int r, int Tangle, int Clock, int Clock2, int pdCode[][7],
      */
       if ((Clock == 3 && Clock2 == 0) || (Clock == 1 && Clock2 == 2)) {
       // addition formula if one of the tangles is (n/1)
-      if (abs(pdCode[Tangle][5]) == 1 || abs(pdCode[tangle2i][5]) == 1) {
+      if (llabs(pdCode[Tangle][5]) == 1 || llabs(pdCode[tangle2i][5]) == 1) {
         canADD = 1;
         pdCode[tangle2i][4] = pdCode[Tangle][4] * pdCode[tangle2i][5] +
                               pdCode[Tangle][5] * pdCode[tangle2i][4];
@@ -291,7 +502,7 @@ int addTangles(int r, int Tangle, int Clock, int Clock2, int pdCode[][7],
     /* Multiply tangles (vertical sum) */
       if ((Clock == 3 && Clock2 == 2) || (Clock == 1 && Clock2 == 0)) {
       // addition formula if one of the tangles is (1/n)
-      if (abs(pdCode[Tangle][4]) == 1 || abs(pdCode[tangle2i][4] == 1)) {
+      if (llabs(pdCode[Tangle][4]) == 1 || abs(pdCode[tangle2i][4] == 1)) {
         canADD = 2;
         pdCode[tangle2i][5] = pdCode[Tangle][4] * pdCode[tangle2i][5] +
                               pdCode[Tangle][5] * pdCode[tangle2i][4];
@@ -412,46 +623,73 @@ int addTangles(int r, int Tangle, int Clock, int Clock2, int pdCode[][7],
   //return rotated;
 }
 
-// remove rows in pdCode where tangle has been combined with another tangle
 /*
-  Slides rows in pdCode up to move all zero rows to the bottom. The edge matrix
-  is also updated to accomodate these changes
+  A tangle absorbed by combineTanglesPDandEdge is left in place with its row
+  zeroed. 0/0 is not the fraction of any tangle, so the zeroed row marks the
+  tangle as removed while 0/1 and 1/0 tangles stay live.
+*/
+int isRemoved(tangleInt pdCode[][7], int Tangle){
+  return pdCode[Tangle][4] == 0 && pdCode[Tangle][5] == 0;
+}
+
+/*
+  Drops removed tangles from a list of tangle indices in place, keeping the
+  order, and returns how many remain.
+*/
+static int liveTangles(const tangleTable *table, int live[], int count){
+  int kept = 0;
+  for (int i = 0; i < count; i++) {
+    if (!tableRemoved(table, live[i])) {
+      live[kept++] = live[i];
+    }
+  }
+  return kept;
+}
+
+/*
+  Slides the remaining rows of pdCode up over the removed ones and relabels
+  the crossings in edge to match, so the algebraic stage sees the tangles in
+  rows 0 to newRow - 1. Returns the new newRow, or -1 when scratch ran out
+  and pdCode is left as it was.
 */
-int removeTangles(int r, int pdCode[r][7], int edge[2 * r + 2][4], int newRow) {
+int removeTangles(int r, tangleInt pdCode[r][7], int edge[2 * r + 2][4], int newRow, arena *scratch) {
   int i, j, k;
-  //lowers each crossing label in edge for each arc by the number of zero rows in pdCode
-  // for loop must be descending to ensure we reduce the crossing number correctly
-  for (i = newRow; i > 0; i--) {
-    if (pdCode[i][4] == 0 || pdCode[i][5] == 0) {
-      for (j = 0; j < 2 * r + 2; j++) {
-        if (edge[j][0] > i - 1){
-          edge[j][0] = edge[j][0] - 1;
-        }
-        if (edge[j][2] > i - 1){
-          edge[j][2] = edge[j][2] - 1;
+  //position[i] is the row tangle i moves to
+  int *position = arenaAlloc(scratch, (newRow + 1) * sizeof(int));
+  int live = 0;
+  if (position == NULL) {
+    return -1;
+  }
+  for (i = 0; i < newRow; i++) {
+    position[i] = live;
+    if (!isRemoved(pdCode, i)) {
+      if (i != live) {
+        for (k = 0; k < 7; k++) {
+          pdCode[live][k] = pdCode[i][k];
         }
+        STAT_ADD(rowsCompacted, 1);
+        TRACE(TRACE_REMOVE, i, live, -1, -1, pdCode[live][4], pdCode[live][5]);
       }
+      live++;
+    } else {
+      TRACE(TRACE_REMOVE, i, -1, -1, -1, 0, 0);
+    }
+  }
+  for (i = live; i < newRow; i++) {
+    for (k = 0; k < 7; k++) {
+      pdCode[i][k] = 0;
     }
   }
 
-  int Start = newRow;
-  for (i = Start - 1; i > -1; i--) {
-    if (pdCode[i][4] == 0 || pdCode[i][5] == 0) {
-      if (i == newRow - 1)
-        newRow = newRow - 1;
-      else {
-        for (j = i; j < newRow - 1; j++)
-          for (k = 0; k < 7; k++) {
-            pdCode[j][k] = pdCode[j + 1][k];
-          }
-        for (k = 0; k < 7; k++) {
-          pdCode[newRow - 1][k] = 0;
-        }
-        newRow = newRow - 1;
+  STAT_ADD(edgeRowsScanned, 2 * r + 2);
+  for (j = 0; j < 2 * r + 2; j++) {
+    for (k = 0; k < 4; k += 2) {
+      if (edge[j][k] >= 0 && edge[j][k] < newRow) {
+        edge[j][k] = position[edge[j][k]];
       }
     }
   }
-  return newRow;
+  return live;
 }
 
 
@@ -463,9 +701,10 @@ N(a/b + t/w) = N((aw + bt)/(xw + yt))
              = N((aw + tb)/(ty  + xw))
 where a'b - ab' = 1 and x b - ay = 1
 Thus a' = x and b' = y
+Returns 1, or -1 when a/b has no x and y and pdCode is left as it was.
 */
-int addRationalTangles(int r, int pdCode[r][7], int edge[][4]) {
-  int a, b, t, w, x, y;
+int addRationalTangles(int r, tangleInt pdCode[r][7], int edge[][4], int *overflow) {
+  tangleInt a, b, t, w, x, y;
   
   //Store current numerator and denominator of first tangle as 'a' and 'b' respectively.
   a = pdCode[0][4];
@@ -492,7 +731,7 @@ int addRationalTangles(int r, int pdCode[r][7], int edge[][4]) {
     Indicating a rotation by 90 degrees of both tangles in their fraction by taking
     each n/m to m/(-n).
     */
-    int temp = b;
+    tangleInt temp = b;
     b = -a; // vertical sum
     a = temp;  // Note a/b rotated 90 degrees = -b/a
     temp = w;
@@ -544,7 +783,7 @@ int addRationalTangles(int r, int pdCode[r][7], int edge[][4]) {
   
   // the setup is a sum, if the second term is integral, combination is easy
   if( w == 1){
-    pdCode[0][4] = a + b*t;
+    pdCode[0][4] = fractionAdd(a, fractionMul(b, t, overflow), overflow);
     pdCode[0][1] = pdCode[1][1];
     pdCode[0][2] = pdCode[1][2];
     
@@ -555,13 +794,22 @@ int addRationalTangles(int r, int pdCode[r][7], int edge[][4]) {
     for(int i = 0; i < 7; i++){
       pdCode[1][i] = 0;
     }
+    TRACE(TRACE_MERGE, 1, 0, -1, -1, pdCode[0][4], pdCode[0][5]);
 
     return 1;
   }
   
 
-  x = ainversemodb(b, a);
-  y = (b * x - 1) / a;
+  //a zero tangle 0/1 adds nothing; bx - ay = 1 has x = b then, and any y
+  if(a == 0){
+    x = b;
+    y = 0;
+  } else if((activeBig != NULL ? bigInverse(b, a, &x) : ainversemodb(b, a, &x)) == 0){
+    y = fractionDiv(fractionAdd(fractionMul(b, x, overflow), -1, overflow), a);
+  } else {
+    //a/b is not in lowest terms, which no merge leaves unless a fraction overflowed
+    return -1;
+  }
   /* 
   This check is probably uneeded
   if (b * x - a * y != 1)
@@ -574,16 +822,17 @@ int addRationalTangles(int r, int pdCode[r][7], int edge[][4]) {
     pdCode[0][i] = pdCode[0][i];
   }
   */
-  pdCode[0][4] = a * w + b * t;
-  pdCode[0][5] = x * w + y * t;
-  if (abs(pdCode[0][4]) < abs(pdCode[0][5])){
-    pdCode[0][5] = pdCode[0][5]%(abs(pdCode[0][4]));
+  pdCode[0][4] = fractionAdd(fractionMul(a, w, overflow), fractionMul(b, t, overflow), overflow);
+  pdCode[0][5] = fractionAdd(fractionMul(x, w, overflow), fractionMul(y, t, overflow), overflow);
+  if (pdCode[0][4] != 0 && fractionAbsLess(pdCode[0][4], pdCode[0][5])){
+    pdCode[0][5] = fractionMod(pdCode[0][5], llabs(pdCode[0][4]));
   }
+  TRACE(TRACE_MERGE, 1, 0, -1, -1, pdCode[0][4], pdCode[0][5]);
   int oneRow = 1;
   return oneRow;
 }
 
-void insertZeroRows(int where, int amount, int newRow, int pdCode[][7]){
+void insertZeroRows(int where, int amount, int newRow, tangleInt pdCode[][7]){
   if(amount != 0){
     for(int i = newRow + amount; i > where + amount; i--){
       for(int j = 0; j < 7; j++){
@@ -612,23 +861,11 @@ void insertZeroRows(int where, int amount, int newRow, int pdCode[][7]){
   }
 }*/
 
-int main(int argc, char *argv[]) {
-  if ( argc < 2) return 1;
-  
-  int row;
-  int (*pdCode)[7] = parse(argv[1], &row);
-  //The seventh column stores operation so that
-  //tangle i connects to tangle i+1 by operation pdCode[i][6]
-  //operations are -1 = *, 0 = ?, 1 = +.
-
-  pdToConway(row, pdCode);
-}
-
 /*
  * Given the pdCode of a knot along with its corresponding edge matrix
  * compute the writhe of the knot.
  */
-int compute_writhe(int rows, int pdCode[][7], int edge[2*rows + 2][4] ){
+int compute_writhe(int rows, tangleInt pdCode[][7], int edge[2*rows + 2][4] ){
 
   int crossing2 = 0;
   int crossing2Clock = 0;
@@ -674,49 +911,38 @@ int compute_writhe(int rows, int pdCode[][7], int edge[2*rows + 2][4] ){
   return writhe;
 }
 
-void sort(int row, int newRow, int pdCode[][7], int edge[][4]){
+void sort(int row, int newRow, tangleInt pdCode[][7], int edge[][4]){
     
-  int temp[6];
+  tangleInt temp[6];
   int sorted = 1;
   while(sorted > 0){
     for (int i=0; i < newRow-1; i++){
       sorted = 0;
-      if(abs(pdCode[i][4]) < abs(pdCode[i+1][4])){
+      if(llabs(pdCode[i][4]) < llabs(pdCode[i+1][4])){
         sorted = 1;
         for(int j = 0; j < 6; j++){
           temp[j] = pdCode[i][j];
           pdCode[i][j] = pdCode[i+1][j];
           pdCode[i+1][j] = temp[j];
         }
-        for(int k = 0; k < 2*row; k++){
-          if(edge[k][0] == i){
-            edge[k][0] = i+1;
-          } else if (edge[k][0] == i+1){
-            edge[k][0] = i;
-          }
-          if(edge[k][2] == i){
-            edge[k][2] = i+1;
-          }else if (edge[k][2] == i+1){
-            edge[k][2] = i;
-          }
-        } 
+        swapTangleArcs(i, i+1, pdCode, edge);
       }
     }
   }
 }
 
-void makeCanonical(int start, int end, int pdCode[][7], int sign, int *remainder, int orientation){
+int makeCanonical(int start, int end, tangleInt pdCode[][7], int sign, int *remainder, int orientation, tangleResult *result){
 
   if(end - start > 1){
     if(sign == -1){
-      printf("-");
+      appendResult(result, "-");
       for (int i = start; i < end; i++){
         pdCode[i][4] *= -1;
       }
       *remainder *= -1;
     }
     if(orientation%2==0){
-      int temp = 0;
+      tangleInt temp = 0;
       for(int i = start; i < end; i++){
         temp = pdCode[i][4];
         pdCode[i][4] = pdCode[i][5];
@@ -727,15 +953,15 @@ void makeCanonical(int start, int end, int pdCode[][7], int sign, int *remainder
     }
     
     
-    int a, b, q;  
+    tangleInt a, b, q;  
     for(int i = start; i < end; i++){
       a = pdCode[i][4];
       b = pdCode[i][5];
-      if(b == 1 || a == 0){
+      if(b == 1 || b == 0 || a == 0){
         /*mostly unecessary check assuming all integer/vertical/rational tangles
         *were created correctly, and the isMontesinos check passed.*/
-        printf("Potentially non-Montesinos");
-        exit(-1);
+        appendResult(result, "Potentially non-Montesinos");
+        return -1;
       } else {
         q = aModB(a, b);
         pdCode[i][4] = q;
@@ -744,7 +970,7 @@ void makeCanonical(int start, int end, int pdCode[][7], int sign, int *remainder
     }
     
     // We should sort by largest separation (den) - (num)
-    int temp = 0;
+    tangleInt temp = 0;
     for(int i = start; i < end-1; i++){
       if(pdCode[i][5] - pdCode[i][4] < pdCode[i+1][5] - pdCode[i+1][4]||pdCode[i][5] < pdCode[i+1][5]){
         for(int j = 0; j < 6; j++){
@@ -755,7 +981,7 @@ void makeCanonical(int start, int end, int pdCode[][7], int sign, int *remainder
       }
     }
     if(orientation%2==0){
-      int temp = 0;
+      tangleInt temp = 0;
       for(int i = start; i < end; i++){
         temp = pdCode[i][4];
         pdCode[i][4] = pdCode[i][5];
@@ -763,17 +989,18 @@ void makeCanonical(int start, int end, int pdCode[][7], int sign, int *remainder
       }
     }
   } else if (end - start == 1&&sign == -1){
-    printf("-");
+    appendResult(result, "-");
     pdCode[start][4] *= -1;
 
   }
+  return 0;
 }
 /*
   Accepts pdCode and operations to check whether the algebraic tangle
   a Montesinos tangle, i.e. may be expressed as either a horizontal
   sum of vertical tangles or as a verticle product of horizontal tangles
 */
-int isMontesino(int startRow, int endRow, int pdCode[][7], int isComponent){
+int isMontesino(int startRow, int endRow, tangleInt pdCode[][7], int isComponent){
   //-1 is always bad, we need an operation unless its polyhedral
   if(pdCode[startRow][6] == 0){
     return -1;
@@ -817,9 +1044,9 @@ int isMontesino(int startRow, int endRow, int pdCode[][7], int isComponent){
   }
 }
 
-int majoritySign(int start, int end, int pdCode[][7], int *remainder, int orientation){
+int majoritySign(int start, int end, tangleInt pdCode[][7], int *remainder, int orientation){
   int posCount=0;
-  int adjust=0;
+  tangleInt adjust=0;
   if(orientation%2==0){
     for(int i = start; i < end; i++){
       //pdCode[i][4]*= -1;
@@ -882,75 +1109,64 @@ int majoritySign(int start, int end, int pdCode[][7], int *remainder, int orient
   }
 }
 
-void getFraction(int start, int end, int newRow, int pdCode[][7], int *remainder, int sign, int orientation){
+void getFraction(int start, int end, int newRow, tangleInt pdCode[][7], int *remainder, int sign, int orientation, tangleResult *result){
   if(end - start == newRow){
-    printf("N(%d/%d", pdCode[0][4], pdCode[0][5]);
+    appendResult(result, "N(%lld/%lld", pdCode[0][4], pdCode[0][5]);
     for(int i = 1; i < newRow; i++){
       if(pdCode[i-1][6]==1){
-        printf(" + ");
+        appendResult(result, " + ");
       }
       if(pdCode[i-1][6]==-1){
-        printf(" * ");
+        appendResult(result, " * ");
       }
-      printf("%d/%d", pdCode[i][4], pdCode[i][5]);
+      appendResult(result, "%lld/%lld", pdCode[i][4], pdCode[i][5]);
     }
     if(*remainder!= 0){
-      printf(" + %d),", *remainder);
+      appendResult(result, " + %d),", *remainder);
     } else {
-      printf("),");
+      appendResult(result, "),");
     }
   } else{
-    printf("(%d/%d", pdCode[start][4], pdCode[start][5]);
+    appendResult(result, "(%lld/%lld", pdCode[start][4], pdCode[start][5]);
   
     for(int i = start; i < end-1; i++){
       if(pdCode[i][6]==1){
-        printf(" + ");
+        appendResult(result, " + ");
       }
       if(pdCode[i][6]==-1){
-        printf(" * ");
+        appendResult(result, " * ");
       }
-      printf("%d/%d", pdCode[i+1][4], pdCode[i+1][5]);
+      appendResult(result, "%lld/%lld", pdCode[i+1][4], pdCode[i+1][5]);
     
     }
   
     if(*remainder == 0){
-      printf(")");
+      appendResult(result, ")");
     } else {
       if(orientation%2==1){
-        printf(" + %d)", *remainder);
+        appendResult(result, " + %d)", *remainder);
       }
       else{
-        printf(" * 1/%d)", *remainder);
+        appendResult(result, " * 1/%d)", *remainder);
       }
     }
   }
 }
 
-void getConway(int a, int b){
-  int A_i = a/b; //Conway output this step
-  int r = aModB(a, b); // a/b = A_i + r/b
-  if(r > 1){//if remainder is more than one, flip the fraction and do it again
-    getConway(b, r);
-  } else if (r > 0){
-    printf("%d", b);
-  }
-  printf(" %d", A_i);
-}
-
-void getConwayMontesinos(int sign,int remainder, int start, int stop, int newRow, int pdCode[][7]){
+void getConwayMontesinos(int sign,int remainder, int start, int stop, int newRow, tangleInt pdCode[][7], tangleResult *result){
   
   if(sign == -1){
-        printf("-");
+        appendResult(result, "-");
       }
       if(stop - start < newRow){
-        printf("(");
+        appendResult(result, "(");
       }else {
-        printf("[");
+        appendResult(result, "[");
       }
       for(int i = start; i < stop; i++){
-        getConway(pdCode[i][4], pdCode[i][5]);
+        appendConway(result, pdCode[i][4], pdCode[i][5]);
         if(i < stop - 1){
-          printf("|");
+          appendResult(result, "|");
         }
       }
       if(remainder != 0){
@@ -959,62 +1175,67 @@ void getConwayMontesinos(int sign,int remainder, int start, int stop, int newRow
           pm = '-';
         }
         for(int i = 0; i < abs(remainder); i++){
-          printf("%c", pm);
+          appendResult(result, "%c", pm);
         }
       }
       if(stop - start < newRow){
-        printf(")");
+        appendResult(result, ")");
       } else{
-        printf("]");
+        appendResult(result, "]");
       }
 }
 
-void handleMontesinosComponent(int start, int end, int pdCode[][7], int mont){
-  printf("(%d/%d", pdCode[start][4], pdCode[start][5]);
+void handleMontesinosComponent(int start, int end, tangleInt pdCode[][7], int mont, tangleResult *result){
+  appendResult(result, "(%lld/%lld", pdCode[start][4], pdCode[start][5]);
   for(int i = start+1; i < end; i++){
     if(mont == 0){
-      printf(" + ");
+      appendResult(result, " + ");
     } else if (mont == 1){
-      printf(" * ");
+      appendResult(result, " * ");
     }
-    printf("%d/%d", pdCode[i][4], pdCode[i][5]);
+    appendResult(result, "%lld/%lld", pdCode[i][4], pdCode[i][5]);
   }
-  printf(")");
+  appendResult(result, ")");
 }
 
-void handleMontesinos(int newRow, int pdCode[][7]){
+int handleMontesinos(int newRow, tangleInt pdCode[][7], tangleResult *result){
   int mont = isMontesino(0, newRow, pdCode, 0);
     if(mont == 0){
       //Assuming Montesinos, we output current continued fraction expression
-      printf("N(%d/%d", pdCode[0][4], pdCode[0][5]);
+      appendResult(result, "N(%lld/%lld", pdCode[0][4], pdCode[0][5]);
       for(int i = 0; i < newRow-1; i++){
         if(pdCode[i+1][4]!=0){
           if(pdCode[i][6] == 1){
-            printf(" + ");
+            appendResult(result, " + ");
           }
           if(pdCode[i][6]==-1){
-            printf(" * ");
+            appendResult(result, " * ");
           }
-          printf("%d/%d", pdCode[i+1][4], pdCode[i+1][5]);
+          appendResult(result, "%lld/%lld", pdCode[i+1][4], pdCode[i+1][5]);
         }
       }
-      printf("),");
+      appendResult(result, "),");
       //Now we want to get each fraction into the same sign, whatever is the majority
       int remainder=0;
       int sign = 0;
       sign = majoritySign(0, newRow, pdCode, &remainder, 1);
-      makeCanonical(0, newRow, pdCode, sign, &remainder, 1);
-      getFraction(0, newRow,newRow, pdCode, &remainder, sign, 1);
-      getConwayMontesinos(sign, remainder,0, newRow, newRow, pdCode);
-      printf(",");
+      if(makeCanonical(0, newRow, pdCode, sign, &remainder, 1, result) != 0){
+        return CONWAY_NOT_MONTESINOS;
+      }
+      getFraction(0, newRow,newRow, pdCode, &remainder, sign, 1, result);
+      getConwayMontesinos(sign, remainder,0, newRow, newRow, pdCode, result);
+      appendResult(result, ",");
 
-      getFraction(0, newRow, newRow, pdCode, &remainder, -sign, 1);
-      getConwayMontesinos(-sign, remainder, 0, newRow, newRow, pdCode);
-      printf(",");
+      getFraction(0, newRow, newRow, pdCode, &remainder, -sign, 1, result);
+      getConwayMontesinos(-sign, remainder, 0, newRow, newRow, pdCode, result);
+      appendResult(result, ",");
+      result->classification = TANGLE_MONTESINOS;
+      return CONWAY_OK;
     }
+    return CONWAY_UNRESOLVED;
 }
 
-void orientAlgebraic(int pieces, int newRow, int row, int components[], int pdCode[][7], int edge[][4]){
+int orientAlgebraic(int pieces, int newRow, int row, int components[], tangleInt pdCode[][7], int edge[][4], tangleResult *result){
   // if pieces is even, first piece should be oppositely oriented
       //i.e. expected mont operation is * or (-1)
     // if pieces is odd, first piece should be normally oriented
@@ -1129,14 +1350,7 @@ void orientAlgebraic(int pieces, int newRow, int row, int components[], int pdCo
               //rotate = 3 is 90 CW (0->3->2->1->0); orig -> (orig + rotate)%4
               pdCode[j][k] = temp[(k + 2 + rotate)%4];
             }
-            for(int k = 0; k < 2*row; k++){
-              if(edge[k][0]==j){
-                edge[k][1] = (edge[k][1] + 2 + rotate)%4;
-              }
-              if(edge[k][2]==j){
-                edge[k][3] = (edge[k][3] + 2 + rotate)%4;
-              }
-            }
+            shiftTangleClocks(j, 2 + rotate, pdCode, edge);
             pdCode[j][6]*=-1;
           }
           
@@ -1167,14 +1381,7 @@ void orientAlgebraic(int pieces, int newRow, int row, int components[], int pdCo
             for(int k = 0; k < 4; k++){
               pdCode[j][k] = temp[(k + 2)%4];
             }
-            for(int k = 0; k < 2*row; k++){
-              if(edge[k][0]==j){
-                edge[k][1] = (edge[k][1] + 2)%4;
-              }
-              if(edge[k][2]==j){
-                edge[k][3] = (edge[k][3] + 2)%4;
-              }
-            }
+            shiftTangleClocks(j, 2, pdCode, edge);
           }
         }
 
@@ -1227,7 +1434,7 @@ void orientAlgebraic(int pieces, int newRow, int row, int components[], int pdCo
             diff = components[i+2] - components[i+1] - size;
             insertZeroRows(components[here+1]-1, diff, newRow, pdCode);
             //included zero rows to components[location] piece to make them equal sizes
-            for(int j = components[i+1]; i < components[i+1] + size + diff; j++){
+            for(int j = components[i+1]; j < components[i+1] + size + diff; j++){
               swapTanglesAB(j, components[here] + j - components[i+1], newRow, pdCode,row, edge);
             } 
             
@@ -1266,14 +1473,7 @@ void orientAlgebraic(int pieces, int newRow, int row, int components[], int pdCo
               //rotate = 3 is 90 CCW (0->1->2->3->0); orig -> (orig + 2 + rotate) mod 4
               pdCode[j][k] = temp[(k + rotate)%4];
             }
-            for(int k = 0; k < 2*row; k++){
-              if(edge[k][0]==j){
-                edge[k][1] = (edge[k][1] +rotate)%4;
-              }
-              if(edge[k][2]==j){
-                edge[k][3] = (edge[k][3] +rotate)%4;
-              }
-            }
+            shiftTangleClocks(j, rotate, pdCode, edge);
             pdCode[j][6] *= -1;
           }
           if ((rotate==1&&pdCode[components[i+1]][6]==1)||(rotate == 3 && pdCode[components[i+1]][6] == -1)){//reverse the order of tangles making up the Montesinos component
@@ -1302,14 +1502,7 @@ void orientAlgebraic(int pieces, int newRow, int row, int components[], int pdCo
             }for(int k = 0; k < 4; k++){
               pdCode[j][k] = temp[(k+2)%4];
             }
-            for(int k = 0; k < 2*row; k++){
-              if(edge[k][0]==j){
-                edge[k][1] = (edge[k][1] + 2)%4;
-              }
-              if(edge[k][2]==j){
-                edge[k][3] = (edge[k][3] + 2)%4;
-              }
-            }
+            shiftTangleClocks(j, 2, pdCode, edge);
           }
         }
         pdCode[components[i+1]-1][6] = 1;
@@ -1349,7 +1542,7 @@ void orientAlgebraic(int pieces, int newRow, int row, int components[], int pdCo
             size = components[i+2] - components[i+1];
             diff = components[here+1] - components[here] - size;
             insertZeroRows(components[i+2]-1, diff, newRow, pdCode);
-            for(int j = components[i+1]; i < components[i+1]+size+diff; j++){
+            for(int j = components[i+1]; j < components[i+1]+size+diff; j++){
               swapTanglesAB(j, components[here]+j-components[i+1], newRow, pdCode, row, edge);
             }
             for(int j = components[here+1]-diff; j < newRow + diff; j++){
@@ -1399,14 +1592,7 @@ void orientAlgebraic(int pieces, int newRow, int row, int components[], int pdCo
             for(int k = 0; k < 4; k++){
               pdCode[j][k] = temp[(k+rotate)%4];
             }
-            for(int k = 0; k < 2*row; k++){
-              if(edge[k][0]==j){
-                edge[k][1] = (edge[k][1] +rotate)%4;
-              }
-              if(edge[k][2]==j){
-                edge[k][3] = (edge[k][3] +rotate)%4;
-              }
-            }
+            shiftTangleClocks(j, rotate, pdCode, edge);
             pdCode[j][6] *= -1;
           }
           if((rotate == 1 && pdCode[components[i+1]][6] == 1)||(rotate == 3 && pdCode[components[i+1]][6]== -1)){
@@ -1438,20 +1624,13 @@ void orientAlgebraic(int pieces, int newRow, int row, int components[], int pdCo
             for(int k = 0; k < 4; k++){
               pdCode[j][k] = temp[(k+2)%4];
             }
-            for(int k = 0; k < 2*row; k++){
-              if(edge[k][0]==j){
-                edge[k][1] = (edge[k][1] + 2)%4;
-              }
-              if(edge[k][2]==j){
-                edge[k][3] = (edge[k][3] + 2)%4;
-              }
-            }
+            shiftTangleClocks(j, 2, pdCode, edge);
           }
         }
         pdCode[components[i+1]-1][6] = 1;
         pdCode[components[i+2]-1][6] = 0;
         top_right=i+1;
-        printf("\n");
+        appendResult(result, "\n");
         
         continue;
       }
@@ -1496,7 +1675,7 @@ void orientAlgebraic(int pieces, int newRow, int row, int components[], int pdCo
             insertZeroRows(components[here+1]-1, diff, newRow, pdCode);
             //included zero rows to components[location] piece to make them equal sizes
           
-            for(int j = components[i+1]; i < components[i+1] + size + diff; j++){
+            for(int j = components[i+1]; j < components[i+1] + size + diff; j++){
               swapTanglesAB(j, components[here] + j - components[i+1], newRow, pdCode,row, edge);
             }
             for(int j = components[i+2]-diff; j < newRow + diff; j++){
@@ -1534,14 +1713,7 @@ void orientAlgebraic(int pieces, int newRow, int row, int components[], int pdCo
               //rotate = 3 is 90 CW (0->3->2->1->0); orig -> (orig + rotate)%4
               pdCode[j][k] = temp[(k + 2 + rotate)%4];
             }
-            for(int k = 0; k < 2*row; k++){
-              if(edge[k][0]==j){
-                edge[k][1] = (edge[k][1] + 2 + rotate)%4;
-              }
-              if(edge[k][2]==j){
-                edge[k][3] = (edge[k][3] + 2 + rotate)%4;
-              }
-            }
+            shiftTangleClocks(j, 2 + rotate, pdCode, edge);
             pdCode[j][6]*=-1;
           }
           if((rotate==1 && pdCode[components[i+1]][6] == -1) || (rotate == 3 && pdCode[components[i+1]][6] == 1)){//CCW makes first in sum, last in product
@@ -1571,14 +1743,7 @@ void orientAlgebraic(int pieces, int newRow, int row, int components[], int pdCo
             for(int k = 0; k < 4; k++){
               pdCode[j][k] = temp[(k + 2)%4];
             }
-            for(int k = 0; k < 2*row; k++){
-              if(edge[k][0]==j){
-                edge[k][1] = (edge[k][1] + 2)%4;
-              }
-              if(edge[k][2]==j){
-                edge[k][3] = (edge[k][3] + 2)%4;
-              }
-            }
+            shiftTangleClocks(j, 2, pdCode, edge);
           }
         }
         pdCode[components[i+1]-1][6] = -1;
@@ -1590,7 +1755,7 @@ void orientAlgebraic(int pieces, int newRow, int row, int components[], int pdCo
     else{//This is a single rational tangle in combination with montesinos
       //Repeat either if, but sums and products use only single tangle.
       //might need to check how single component combines with the previous one
-      printf("Possibly non-algebraic, N(");
+      appendResult(result, "Possibly non-algebraic, N(");
       for(int i = 0; i < newRow-1; i ++){
         char op = '?';
         if(pdCode[i][6]==1){
@@ -1598,12 +1763,14 @@ void orientAlgebraic(int pieces, int newRow, int row, int components[], int pdCo
         } else if (pdCode[i][6]==-1){
           op = '*';
         }
-        printf("%d/%d %c", pdCode[i][4], pdCode[i][5], op);
+        appendResult(result, "%lld/%lld %c", pdCode[i][4], pdCode[i][5], op);
       }
-      printf("%d/%d),,,,", pdCode[newRow-1][4], pdCode[newRow-1][5]);
-      exit(0);
+      appendResult(result, "%lld/%lld),,,,", pdCode[newRow-1][4], pdCode[newRow-1][5]);
+      result->classification = TANGLE_NON_ALGEBRAIC;
+      return CONWAY_NOT_ALGEBRAIC;
     }
   }
+  return CONWAY_OK;
 }
 
 /*
@@ -1611,12 +1778,18 @@ void orientAlgebraic(int pieces, int newRow, int row, int components[], int pdCo
   fraction decomposition in the form of a sum of continued
   fractions N(a_1/b_1 + ... a_n/b_n).
 */
-void algTangle(int row, int newRow, int pdCode[][7], int edge[][4]){ 
+int algTangle(int row, int newRow, tangleInt pdCode[][7], int edge[][4], tangleResult *result, arena *scratch){ 
   int tangle2i, tangle2iClock, tangle2ii, tangle2iiClock;
+  STAGE_END(STAGE_ALGEBRAIC);
   sort(row, newRow, pdCode, edge);
+  STAGE_END(STAGE_SORT);
   int temp[4];
-  int components[newRow];
-  for(int i = 0; i < newRow; i++){
+  //components also records the closing index newRow, plus one spare entry read by orientAlgebraic
+  int *components = arenaAlloc(scratch, (newRow + 2) * sizeof(int));
+  if(components == NULL){
+    return CONWAY_NO_MEMORY;
+  }
+  for(int i = 0; i < newRow + 2; i++){
     components[i]=0;
   }
   
@@ -1667,14 +1840,7 @@ void algTangle(int row, int newRow, int pdCode[][7], int edge[][4]){
           clockAdjust = (tangle2iClock + 2)%4;
           rotateTangleFraction(pdCode, tangle2i);
         }
-        for(int i = 0; i < 2*row; i++){
-          if(edge[i][0] == tangle2i){
-            edge[i][1] = (edge[i][1] + clockAdjust)%4;
-          }
-          if(edge[i][2] == tangle2i){
-            edge[i][3] = (edge[i][3] + clockAdjust)%4;
-          }
-        }
+        shiftTangleClocks(tangle2i, clockAdjust, pdCode, edge);
         if(tangle2i > Tangle+1){
           swapTanglesAB(Tangle+1, tangle2i, newRow, pdCode, row, edge);
         }
@@ -1720,14 +1886,7 @@ void algTangle(int row, int newRow, int pdCode[][7], int edge[][4]){
         else {
           clockAdjust = (tangle2iiClock + 2)%4;
         }
-        for(int i = 0; i < 2*row; i++){
-          if(edge[i][0] == tangle2i){
-            edge[i][1] = (edge[i][1] + clockAdjust)%4;
-          }
-          if(edge[i][2] == tangle2i){
-            edge[i][3] = (edge[i][3] + clockAdjust)%4;
-          }
-        }
+        shiftTangleClocks(tangle2i, clockAdjust, pdCode, edge);
         if(tangle2i > Tangle+1){
           swapTanglesAB(Tangle+1, tangle2i, newRow, pdCode, row, edge);
         }
@@ -1784,7 +1943,12 @@ void algTangle(int row, int newRow, int pdCode[][7], int edge[][4]){
       //i.e. expected mont operation is + or (1)
     //up to here, pdCode, components, and edge should be accurate, now to verify operations
     
-    orientAlgebraic(k, newRow, row, components, pdCode, edge);
+    STAGE_END(STAGE_ALGEBRAIC);
+    int status = orientAlgebraic(k, newRow, row, components, pdCode, edge, result);
+    STAGE_END(STAGE_ORIENT);
+    if(status != CONWAY_OK){
+      return status;
+    }
     
     //Make sure right most component is summed to the rest, if not, rotate by 90
     if(pdCode[components[k-1]-1][6]== -1){//Then rotate everything 90 CCW Clocks 0->1->2->3->0, op 1 <=> -1
@@ -1801,14 +1965,7 @@ void algTangle(int row, int newRow, int pdCode[][7], int edge[][4]){
           for(int l = 0; l < 4; l++){
             pdCode[j][l] = temp[(l+3)%4];
           }
-          for(int l = 0; l < 2*row; l++){
-            if(edge[l][0]==j){
-              edge[l][1] = (edge[l][1] + 3)%4;
-            }
-            if(edge[l][2]==j){
-              edge[l][3] = (edge[l][3] + 3)%4;
-            }
-          }
+          shiftTangleClocks(j, 3, pdCode, edge);
         }
         if(pdCode[components[i]][6]== -1){//Then this component became a product comp, so was a summed comp and tangle order reverses
           temp[0] = pdCode[components[i]][6];
@@ -1831,21 +1988,24 @@ void algTangle(int row, int newRow, int pdCode[][7], int edge[][4]){
     }
      
 
-    printf("N(");    
+    appendResult(result, "N(");    
     for(int i = 0; i < k; i++){
       int mont=isMontesino(components[i], components[i+1], pdCode, 1);
-      handleMontesinosComponent(components[i], components[i+1],pdCode, mont);
+      handleMontesinosComponent(components[i], components[i+1],pdCode, mont, result);
       if(i < k-1 && pdCode[components[i+1]-1][6]==1){  
-        printf("+");
+        appendResult(result, "+");
       }
       if(i < k-1 && pdCode[components[i+1]-1][6]==-1){
-        printf("*");
+        appendResult(result, "*");
       }
     }
 
-    printf("), N(");
-    int remainder[k];
-    int sign[k];
+    appendResult(result, "), N(");
+    int *remainder = arenaAlloc(scratch, k * sizeof(int));
+    int *sign = arenaAlloc(scratch, k * sizeof(int));
+    if(remainder == NULL || sign == NULL){
+      return CONWAY_NO_MEMORY;
+    }
     for(int i = 0; i < k; i++){
       remainder[i] = 0;
       sign[i] = 0;
@@ -1854,84 +2014,103 @@ void algTangle(int row, int newRow, int pdCode[][7], int edge[][4]){
     for(int i = 0; i < k; i++){
       
       sign[i] = majoritySign(components[i], components[i+1], pdCode, &remainder[i], k-i);
-      makeCanonical(components[i], components[i+1], pdCode, sign[i], &remainder[i], k - i);
+      if(makeCanonical(components[i], components[i+1], pdCode, sign[i], &remainder[i], k - i, result) != 0){
+        return CONWAY_NOT_MONTESINOS;
+      }
       //Might need to split getFrac from the rest so I can pull common negative to the front
-      getFraction(components[i], components[i+1], newRow, pdCode, &remainder[i], sign[i], k-i);
+      getFraction(components[i], components[i+1], newRow, pdCode, &remainder[i], sign[i], k-i, result);
       if(i < k-1){
         if(pdCode[components[i+1] - 1][6] == 1){
-          printf(" + ");
+          appendResult(result, " + ");
         } else if (pdCode[components[i+1] - 1][6] == -1){
-          printf(" * ");
+          appendResult(result, " * ");
         }
       }
     }
-    printf("),[");
+    appendResult(result, "),[");
     for(int i = 0; i < k; i++){
-      getConwayMontesinos(sign[i], remainder[i], components[i], components[i+1], newRow, pdCode);
+      getConwayMontesinos(sign[i], remainder[i], components[i], components[i+1], newRow, pdCode, result);
       if(i < k-1){
-        printf("|");
+        appendResult(result, "|");
       }
     }
-    printf("],,,");
-\
+    appendResult(result, "],,,");
+    result->classification = TANGLE_ALGEBRAIC;
+    return CONWAY_OK;
   } else {
     //standard Montesinos case
-    handleMontesinos(newRow, pdCode);
+    return handleMontesinos(newRow, pdCode, result);
   }
 }
 
 // Given Tangle A, finds a second tangle which can be combined with it along the side specified to create
 // a horizontal or vertical tangle
-int makeHorVtangle(int TangleA, int Clock1, int Clock2, int rows, int pdCode[][7], int edge[][4]){
+/* Marks Tangle and every tangle sharing an arc with it to be tried again by the merge sweeps */
+static void markNeighbours(int Tangle, const tangleTable *table, int edge[][4], int dirty[]){
+  dirty[Tangle] = 1;
+  STAT_ADD(edgeRowsScanned, 4);
+  for(int i = 0; i < 4; i++){
+    int Arc = tableArc(table, Tangle, i);
+    if(edge[Arc][0] >= 0){
+      dirty[edge[Arc][0]] = 1;
+    }
+    if(edge[Arc][2] >= 0){
+      dirty[edge[Arc][2]] = 1;
+    }
+  }
+}
+
+static int makeHorVtangle(int TangleA, int Clock1, int Clock2, tangleTable *table, int edge[][4], int dirty[], int *overflow){
   int TangleB = 0;
   int rotate = 0;
-  int arc1, arc2, tangle2i, tangle2ii, tangle2iClock, tangle2iiClock;
+  int tangle2i, tangle2ii, tangle2iClock, tangle2iiClock;
 
-  if(pdCode[TangleA][4] != 0 && ( abs(pdCode[TangleA][4]) == 1 || pdCode[TangleA][5] == 1 ) ){ 
+  if(!tableRemoved(table, TangleA) && ( llabs(table->num[TangleA]) == 1 || table->den[TangleA] == 1 ) ){ 
 
-    TangleB = canCombine(TangleA, Clock1, Clock2, rows, pdCode, edge);
+    //Get the tangles, and their clocks, at the ends of the arcs at Clock1 and Clock2
+    turnedTangle2(TangleA, Clock1, &tangle2i, &tangle2iClock, table, edge);
+    turnedTangle2(TangleA, Clock2, &tangle2ii, &tangle2iiClock, table, edge);
+    TangleB = tangle2i == tangle2ii && tangle2i >= 0 ? tangle2i : -1;
       
     if(TangleB > -1 && TangleB < TangleA){
-      arc1 = pdCode[TangleA][Clock1];
-      arc2 = pdCode[TangleA][Clock2];
-    
-      //Get clock positions of arcs in TangleB to rotate as needed
-      getTangle2(rows, TangleA, Clock1, &tangle2i, &tangle2iClock, pdCode, edge);
-      getTangle2(rows, TangleA, Clock2, &tangle2ii, &tangle2iiClock, pdCode, edge);
-      
       if(tangle2iClock != (Clock1 + 3) % 4){
         //Need to rotate TangleB
         rotate = (Clock1 + 3 - tangle2iClock) % 4;
-        rotateTangle90CCW_Ntimes(rotate, TangleB, rows, pdCode, edge);
+        turnTangle(TangleB, rotate, table);
+        markNeighbours(TangleB, table, edge, dirty);
+        //TangleA reached TangleB through its own arcs, retry it even if edge disagrees
+        dirty[TangleA] = 1;
       }
     
     //printf("Combinging TangleA = %d to TangleB = %d after rotating TangleB %d along edge %d %d\n", TangleA, TangleB, rotate, Clock1, Clock2);
-      if((Clock1 % 2) == 0 && abs(pdCode[TangleB][4]) == 1 && abs(pdCode[TangleA][4]) == 1){
+      if((Clock1 % 2) == 0 && llabs(table->num[TangleB]) == 1 && llabs(table->num[TangleA]) == 1){
         // Clock1 even => vertical sum, need unit numerators
         
-        if(pdCode[TangleB][4] < 0){
-          pdCode[TangleB][4] *= -1;
-          pdCode[TangleB][5] *= -1;
+        if(table->num[TangleB] < 0){
+          table->num[TangleB] *= -1;
+          table->den[TangleB] *= -1;
         }
-        if(pdCode[TangleA][4] < 0){
-          pdCode[TangleA][4] *= -1;
-          pdCode[TangleA][5] *= -1;
+        if(table->num[TangleA] < 0){
+          table->num[TangleA] *= -1;
+          table->den[TangleA] *= -1;
         }
-        pdCode[TangleB][5] += pdCode[TangleA][5];
+        table->den[TangleB] = fractionAdd(table->den[TangleB], table->den[TangleA], overflow);
 
-        if(pdCode[TangleB][5] < 0){
-          pdCode[TangleB][4] *= -1;
-          pdCode[TangleB][5] *= -1;
+        if(table->den[TangleB] < 0){
+          table->num[TangleB] *= -1;
+          table->den[TangleB] *= -1;
         }      
         
-        combineTanglesPDandEdge(TangleA, TangleB, Clock1, Clock2, rows, pdCode, edge);
+        combineTanglesPDandEdge(TangleA, TangleB, Clock1, Clock2, table, edge);
+        markNeighbours(TangleB, table, edge, dirty);
         
         return 1;
-      } else if((Clock1 % 2) == 1 && pdCode[TangleA][5] == 1 && pdCode[TangleB][5] == 1){
+      } else if((Clock1 % 2) == 1 && table->den[TangleA] == 1 && table->den[TangleB] == 1){
         //Clock1 odd => horizontal sum, need denom of 1
-        pdCode[TangleB][4] += pdCode[TangleA][4];
+        table->num[TangleB] = fractionAdd(table->num[TangleB], table->num[TangleA], overflow);
         
-        combineTanglesPDandEdge(TangleA, TangleB, Clock1, Clock2, rows, pdCode, edge);
+        combineTanglesPDandEdge(TangleA, TangleB, Clock1, Clock2, table, edge);
+        markNeighbours(TangleB, table, edge, dirty);
         
         return 1;
       } else {
@@ -1946,35 +2125,35 @@ int makeHorVtangle(int TangleA, int Clock1, int Clock2, int rows, int pdCode[][7
   }
 }
 
-int makeRationalSimple(int TangleA, int Clock1, int Clock2, int newRow, int rows, int pdCode[][7], int edge[][4]){
-  if(pdCode[TangleA][4] == 0){
+static int makeRationalSimple(int TangleA, int Clock1, int Clock2, tangleTable *table, int edge[][4], int dirty[], int *overflow){
+  if(tableRemoved(table, TangleA)){
     return 0;
   }
   int TangleB = 0;
   int rotate = 0;
   int tangle2i, tangle2ii, tangle2iClock, tangle2iiClock;
-  int arc1 = pdCode[TangleA][Clock1];
-  int arc2 = pdCode[TangleA][Clock2];
 
-  TangleB = canCombine(TangleA, Clock1, Clock2, rows, pdCode, edge);
+  //find where the arcs at Clock1 and Clock2 connect to TangleB to rotate if needed
+  turnedTangle2(TangleA, Clock1, &tangle2i, &tangle2iClock, table, edge);
+  turnedTangle2(TangleA, Clock2, &tangle2ii, &tangle2iiClock, table, edge);
+  TangleB = tangle2i == tangle2ii && tangle2i >= 0 ? tangle2i : -1;
   if(TangleB > -1){
     
-    //find where arc1 and arc2 connect to TangleB to rotate if needed
-    getTangle2(rows, TangleA, Clock1, &tangle2i, &tangle2iClock, pdCode, edge);
-    getTangle2(rows, TangleA, Clock2, &tangle2ii, &tangle2iiClock, pdCode, edge);
-    
     if(tangle2iClock != (Clock1 + 3) % 4){
       rotate = (Clock1 + 3 - tangle2iClock) % 4;
-      rotateTangle90CCW_Ntimes(rotate, TangleB, rows, pdCode, edge);
+      turnTangle(TangleB, rotate, table);
+      markNeighbours(TangleB, table, edge, dirty);
+      //TangleA reached TangleB through its own arcs, retry it even if edge disagrees
+      dirty[TangleA] = 1;
     }
     
     //Need to know if this is a vertical or horizontal combination
-    if( Clock1 % 2 == 1 && ( pdCode[TangleB][5] == 1 || pdCode[TangleA][5] == 1 ) ){
+    if( Clock1 % 2 == 1 && ( table->den[TangleB] == 1 || table->den[TangleA] == 1 ) ){
       
       //This case is a horizontal combination with horizontal tangle
       int horizontal = TangleB;
       int rational = TangleA;
-      if(pdCode[TangleB][5] != 1){
+      if(table->den[TangleB] != 1){
         rational = TangleB;
         horizontal = TangleA;
       }
@@ -1983,46 +2162,48 @@ int makeRationalSimple(int TangleA, int Clock1, int Clock2, int newRow, int rows
       // = (r + b(a' + n)) / b  is the resulting fraction
       // a' is the same as floor(a/b) and r is the same as a modulo b 
       
-      int a = pdCode[rational][4];
-      int b = pdCode[rational][5];
-      int n = pdCode[horizontal][4];
+      tangleInt a = table->num[rational];
+      tangleInt b = table->den[rational];
+      tangleInt n = table->num[horizontal];
 
-      pdCode[TangleB][4] = a + b*n;
-      pdCode[TangleB][5] = b;
+      table->num[TangleB] = fractionAdd(a, fractionMul(b, n, overflow), overflow);
+      table->den[TangleB] = b;
       
-      combineTanglesPDandEdge(TangleA, TangleB, Clock1, Clock2, rows, pdCode, edge);
+      combineTanglesPDandEdge(TangleA, TangleB, Clock1, Clock2, table, edge);
+      markNeighbours(TangleB, table, edge, dirty);
       
       return 1;
-    } else if( Clock1 % 2 == 0 && ( abs(pdCode[TangleB][4]) == 1 || abs(pdCode[TangleA][4]) == 1 ) ) {
+    } else if( Clock1 % 2 == 0 && ( llabs(table->num[TangleB]) == 1 || llabs(table->num[TangleA]) == 1 ) ) {
       //This case is vertical combination with vertical tangle
       int rational = TangleA;
       int vertical = TangleB;
 
-      if( abs(pdCode[TangleB][4]) != 1){
+      if( llabs(table->num[TangleB]) != 1){
        rational = TangleB;
        vertical  = TangleA; 
       }
       //Push negative to denominator if needed
-      if(pdCode[vertical][4] < 0){
-        pdCode[vertical][4] *= -1;
-        pdCode[vertical][5] *= -1;
+      if(table->num[vertical] < 0){
+        table->num[vertical] *= -1;
+        table->den[vertical] *= -1;
       }
       
       //If TangleA has fraction a/b and TangleB has fraction 1/n
       //Resulting  fraction is 1/ (n + 1/(a/b)) = 1/(n + b/a) 
       // or a/( a*n + b )
-      int a = pdCode[rational][4];
-      int b = pdCode[rational][5];
-      int n = pdCode[vertical][5];
+      tangleInt a = table->num[rational];
+      tangleInt b = table->den[rational];
+      tangleInt n = table->den[vertical];
 
-      pdCode[TangleB][4] = a;
-      pdCode[TangleB][5] = a*n + b;
+      table->num[TangleB] = a;
+      table->den[TangleB] = fractionAdd(fractionMul(a, n, overflow), b, overflow);
 
-      if(pdCode[TangleB][5] < 0){
-        pdCode[TangleB][4] *= -1;
-        pdCode[TangleB][5] *= -1;
+      if(table->den[TangleB] < 0){
+        table->num[TangleB] *= -1;
+        table->den[TangleB] *= -1;
       }
-      combineTanglesPDandEdge(TangleA, TangleB, Clock1, Clock2, rows, pdCode, edge);
+      combineTanglesPDandEdge(TangleA, TangleB, Clock1, Clock2, table, edge);
+      markNeighbours(TangleB, table, edge, dirty);
       return 1;
     } else {
       return 0;
@@ -2032,18 +2213,141 @@ int makeRationalSimple(int TangleA, int Clock1, int Clock2, int newRow, int rows
   }
 }
 
-void pdToConway(int row, int pdCode[][7]){
+/*
+  Bytes of scratch pdToConwayArena expects a tangle of rows crossings to
+  take: the code as given, the edge matrix, simplifyDiagram's lists, the
+  dirty and live lists, the tangle table, position in each of the two calls
+  to removeTangles, and components, remainder and sign in algTangle. Reserving it up front keeps
+  the reduction in one block; an allocation it misses still succeeds, from
+  a block the arena spills into.
+*/
+size_t conwayArenaSize(int rows){
+  size_t ints = (size_t)(2 * rows + 2) * 4 + 2 * rows + 2 * (rows + 1) +
+                (rows + 2) + 2 * (rows + 2);
+  return ints * sizeof(int) + (size_t)rows * 7 * sizeof(tangleInt) + tangleTableSize(rows) +
+         13 * ARENA_ALIGN + simplifyArenaSize(rows);
+}
 
-  int edge[2 * row + 2][4];
-  int i, j, newRow, Tangle, signCrossing[row], crossing2, crossing2Clock,
+/*
+  Reduces the tangle given by pdCode and fills result with its writhe and
+  either its fraction and Conway vector or its Montesinos/algebraic
+  decomposition. Nothing is printed and the process is never exited, so this
+  may be called any number of times. Returns the status also kept in result.
+*/
+int pdToConwayResult(int row, tangleInt pdCode[][7], tangleResult *result){
+  arena scratch;
+  arenaInit(&scratch);
+  int status = pdToConwayArena(row, pdCode, result, &scratch);
+  arenaFree(&scratch);
+  return status;
+}
+
+/*
+  pdToConwayResult taking its scratch from an arena, which is reset here and
+  grown only if the tangle is the largest it has seen, so nothing is left on
+  the stack per crossing and a caller reusing one arena allocates nothing.
+  Built with CONWAY_STATS, the stats of the reduction are left in result;
+  with CONWAY_TRACE, its events go to the ring attached to the thread.
+*/
+static int reduceTangle(int row, tangleInt pdCode[][7], tangleResult *result, arena *scratch);
+
+int pdToConwayArena(int row, tangleInt pdCode[][7], tangleResult *result, arena *scratch){
+  int status;
+
+  resetResult(result);
+  TRACE(TRACE_BEGIN, row, -1, -1, -1, activeTrace->label, 0);
+#ifdef CONWAY_STATS
+  STATS_ATTACH(&result->stats);
+  status = reduceTangle(row, pdCode, result, scratch);
+  STATS_DETACH();
+#else
+  status = reduceTangle(row, pdCode, result, scratch);
+#endif
+  TRACE(TRACE_END, status, result->classification, -1, -1, result->num, result->den);
+  return status;
+}
+
+/*
+  reduceTangle again for a tangle whose fractions outgrew tangleInt, from
+  the code as given, with a bigFractions pool attached so that they are
+  kept at any size. Only a rational result can carry them, in bigNum and
+  bigDen; a Montesinos or algebraic tangle with such a piece still
+  overflows.
+*/
+static int reduceBig(int row, tangleInt pdCode[][7], tangleResult *result, arena *scratch){
+  bigFractions pool;
+
+  //the merge counts are of the reduction that is kept
+  result->mergeAttempts = 0;
+  result->mergeAttemptsSaved = 0;
+  bigAttach(&pool, scratch);
+  reduceTangle(row, pdCode, result, scratch);
+  bigDetach();
+  if(pool.failed){
+    result->status = CONWAY_NO_MEMORY;
+  }
+  return result->status;
+}
+
+/* Fills a rational result with sign*num/den past tangleInt, while the pool holding it is attached */
+static int bigRational(tangleResult *result, int sign, tangleInt num, tangleInt den){
+  int closing;
+  int n = conwayTerms(num, den, result->conway, CONWAY_MAX, &closing);
+  //conwayTerms stops at CONWAY_MAX terms, so a vector that long may have been cut short
+  int fits = n < CONWAY_MAX;
+
+  for(int i = 0; i < n; i++){
+    fits = fits && !fractionIsBig(result->conway[i]);
+    result->conway[i] *= sign;
+  }
+  if(!fits || bigText(sign * num, result->bigNum, FRACTION_TEXT_MAX) < 0 ||
+     bigText(den, result->bigDen, FRACTION_TEXT_MAX) < 0 ||
+     formatConway(result->bigConway, CONWAY_TEXT_MAX, num, den) >= CONWAY_TEXT_MAX - 1){
+    result->bigNum[0] = 0;
+    result->bigDen[0] = 0;
+    result->bigConway[0] = 0;
+    return CONWAY_OVERFLOW;
+  }
+  result->conwayLength = n;
+  return CONWAY_OK;
+}
+
+/* The body of pdToConwayArena, on a result already reset */
+static int reduceTangle(int row, tangleInt pdCode[][7], tangleResult *result, arena *scratch){
+  if(arenaReset(scratch, conwayArenaSize(row)) != 0){
+    result->status = CONWAY_NO_MEMORY;
+    return result->status;
+  }
+  //the code as given, to start again from should a fraction outgrow tangleInt
+  int givenRows = row;
+  tangleInt (*given)[7] = arenaAlloc(scratch, row * sizeof(*given));
+  int (*edge)[4] = arenaAlloc(scratch, (2 * row + 2) * sizeof(*edge));
+  int i, j, newRow, Tangle, crossing2, crossing2Clock,
       writhe, temp;
 
+  if(given == NULL || edge == NULL){
+    result->status = CONWAY_NO_MEMORY;
+    return result->status;
+  }
+  memcpy(given, pdCode, row * sizeof(*given));
+
   /* Create edge matrix where each ROW corresponds to an Arc */
   createEdge(row, pdCode, edge);
+  STAGE_END(STAGE_CREATE_EDGE);
   
   writhe = compute_writhe(row, pdCode, edge);
-  
-  printf("%d,", writhe);
+  result->writhe = writhe;
+  STAGE_END(STAGE_WRITHE);
+
+  /* Kinks and removable bigons would only be merged as real crossings; the writhe above is still the input's */
+  result->crossingsRemoved = simplifyDiagram(&row, pdCode, edge, scratch);
+  if(result->crossingsRemoved < 0){
+    result->crossingsRemoved = 0;
+    result->status = CONWAY_NO_MEMORY;
+    return result->status;
+  }
+  STAT_ADD(crossingsRemoved, result->crossingsRemoved);
+  STAGE_END(STAGE_SIMPLIFY);
 
   /*******************************************************************/
   /**** combine 1/1 tangles into (n/1) and (1/n) tangles  **************/
@@ -2063,41 +2367,115 @@ void pdToConway(int row, int pdCode[][7]){
   int canADD,arc1, arc2, tangle2i, tangle2ii, tangle2iClock, tangle2iiClock;
   int added = 1;
 
+  /*
+    The sweeps below only retry a tangle when it, or a tangle sharing an arc
+    with it, has been merged into or rotated since it was last tried. Any
+    other tangle would fail exactly as before, so the merges happen in the
+    same order as a full sweep while skipping those attempts.
+  */
+  int *dirty = arenaAlloc(scratch, row * sizeof(int));
+  int overflow = 0;
+  int *live = arenaAlloc(scratch, row * sizeof(int));
+  int liveCount = row;
+  tangleTable table;
+  if(dirty == NULL || live == NULL || loadTangleTable(row, pdCode, &table, scratch) != 0){
+    result->status = CONWAY_NO_MEMORY;
+    return result->status;
+  }
+  for(i = 0; i < row; i++){
+    dirty[i] = 1;
+    live[i] = i;
+  }
+
+  /*
+    Absorbed tangles stay where they are until both sweeps are done. Each pass
+    walks the live list from the last tangle down to, but not including, the
+    first live tangle, the same tangles and order as walking the rows of a
+    compacted pdCode from newRow - 1 down to 1.
+  */
   //MAKING A VERTIC SUM INTO HORIZONTAL FRAC. ROWS 1 AND 3 MAKE -1/2 NOT -2/1
   while (added > 0){
     added = 0;
-    Tangle = row - 1;
+    liveCount = liveTangles(&table, live, liveCount);
+    //a full sweep would try rows row - 1 down to 1, absorbed or not
+    result->mergeAttemptsSaved += 4 * (row - 1);
     //make simple by adding basic
-    while(Tangle > 0){
-      for(int i = 0; i < 4; i++){
-        added +=makeHorVtangle(Tangle, i, (i + 1) % 4, row, pdCode, edge);
+    for(j = liveCount - 1; j > 0; j--){
+      Tangle = live[j];
+      if(dirty[Tangle]){
+        dirty[Tangle] = 0;
+        for(int i = 0; i < 4; i++){
+          int merged = makeHorVtangle(Tangle, i, (i + 1) % 4, &table, edge, dirty, &overflow);
+          STAT_ADD(horVMerges, merged);
+          added += merged;
+        }
+        STAT_ADD(horVAttempts, 4);
+        result->mergeAttempts += 4;
+        result->mergeAttemptsSaved -= 4;
       }
-      Tangle--;
     }
   }
+  STAGE_END(STAGE_HOR_V);
   
   
 
-  newRow = removeTangles(row, pdCode, edge, row);
   added = 1;
+  for(i = 0; i < row; i++){
+    dirty[i] = 1;
+  }
+  liveCount = liveTangles(&table, live, liveCount);
+  int sweepRows = liveCount;
 
   while(added > 0){
     //make rationals by adding simple
-    Tangle = newRow - 1;
     added = 0;
-    while(Tangle > 0){      
-      for(int i = 0; i < 4; i++){
-        added += makeRationalSimple(Tangle, i, (i + 1) % 4, newRow, row, pdCode, edge);
+    liveCount = liveTangles(&table, live, liveCount);
+    //the full sweep ran over the rows left after compacting the first one
+    result->mergeAttemptsSaved += 4 * (sweepRows - 1);
+    for(j = liveCount - 1; j > 0; j--){
+      Tangle = live[j];
+      if(dirty[Tangle]){
+        dirty[Tangle] = 0;
+        for(int i = 0; i < 4; i++){
+          int merged = makeRationalSimple(Tangle, i, (i + 1) % 4, &table, edge, dirty, &overflow);
+          STAT_ADD(rationalMerges, merged);
+          added += merged;
+        }
+        STAT_ADD(rationalAttempts, 4);
+        result->mergeAttempts += 4;
+        result->mergeAttemptsSaved -= 4;
       }
-      Tangle--;
     }
   }
+  storeTangleTable(row, pdCode, edge, &table);
+  STAGE_END(STAGE_RATIONAL_SIMPLE);
   
-  newRow = removeTangles(row, pdCode, edge, newRow);
+  newRow = removeTangles(row, pdCode, edge, row, scratch);
   
+  int summed = 1;
   if(newRow == 2){
-    addRationalTangles(row, pdCode, edge);
-    newRow = removeTangles(row, pdCode, edge, newRow);
+    summed = addRationalTangles(row, pdCode, edge, &overflow) > 0;
+    newRow = removeTangles(row, pdCode, edge, newRow, scratch);
+  }
+  STAGE_END(STAGE_REMOVE);
+  if(newRow < 0){
+    result->status = CONWAY_NO_MEMORY;
+    return result->status;
+  }
+  if(overflow){
+    memcpy(pdCode, given, givenRows * sizeof(*given));
+    return reduceBig(givenRows, pdCode, result, scratch);
+  }
+  if(!summed){
+    result->status = CONWAY_NOT_COPRIME;
+    return result->status;
+  }
+  //the decompositions algTangle writes give their pieces as tangleInts
+  for(i = 0; newRow > 2 && i < newRow; i++){
+    if(fractionIsBig(pdCode[i][4]) || fractionIsBig(pdCode[i][5])){
+      result->status = CONWAY_OVERFLOW;
+      return result->status;
+    }
   }
 
 
@@ -2236,8 +2614,9 @@ void pdToConway(int row, int pdCode[][7]){
 
     if (added == 0 && newRow > 2){
       
-      algTangle(row, newRow, pdCode, edge);
-      exit(0);
+      result->status = algTangle(row, newRow, pdCode, edge, result, scratch);
+      STAGE_END(STAGE_ALGEBRAIC);
+      return result->status;
     }
   
   /* 
@@ -2301,8 +2680,8 @@ void pdToConway(int row, int pdCode[][7]){
   char add = '&';  // horizontal addition
   char mult = '*'; // vertical addition
   char divide = '/';
-  char string[12]; // create an empty string to store number
-  sprintf(string, "%d", pdCode[0][4]);
+  char string[24]; // create an empty string to store number
+  sprintf(string, "%lld", pdCode[0][4]);
   strncat(string, &divide, 1);
   
   /* 
@@ -2316,8 +2695,8 @@ void pdToConway(int row, int pdCode[][7]){
 
   // adjusting notation to match two-bridges a bad way
   
-  int num;
-  int den;
+  tangleInt num;
+  tangleInt den;
   
   if(pdCode[0][1]==0 || pdCode[0][3]==0){
     rotateTangleFraction(pdCode, 0);
@@ -2335,18 +2714,20 @@ void pdToConway(int row, int pdCode[][7]){
     pm = '-';
     num *= -1;
   }
-  printf("%d/%d,%c[", sign*num, den, pm);
-  getConway(num, den);
-  printf("],");
-  sign *= -1;
-  if(pm == '-'){
-    pm = ' ';
-  } else {
-    pm = '-';
+  result->classification = TANGLE_RATIONAL;
+  if(fractionIsBig(num) || fractionIsBig(den)){
+    result->status = bigRational(result, sign, num, den);
+    return result->status;
+  }
+  result->num = sign*num;
+  result->den = den;
+  result->mirrorNum = -sign*num;
+  result->mirrorDen = den;
+  int closing;
+  result->conwayLength = conwayTerms(num, den, result->conway, CONWAY_MAX, &closing);
+  for(int i = 0; i < result->conwayLength; i++){
+    result->conway[i] *= sign;
   }
-  printf("%d/%d,%c[",sign*num, den, pm);
-  getConway(num, den);
-  printf("],");
   /* Routine for moving fraction to minimal in the context of knots and links
   int denList[abs(num)];
   i=0;
@@ -2434,4 +2815,12 @@ void pdToConway(int row, int pdCode[][7]){
   getConway(a,b);
   printf("],");
   */
-}
\ No newline at end of file
+  return CONWAY_OK;
+}
+
+/* Reduces the tangle and prints the result in the CSV layout */
+void pdToConway(int row, tangleInt pdCode[][7]){
+  tangleResult result;
+  pdToConwayResult(row, pdCode, &result);
+  printResult(stdout, &result);
+}
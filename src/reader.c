@@ -0,0 +1,92 @@
+#include "reader.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Returns 0, or -1 when the buffer cannot be allocated */
+int readerInit(inputReader *reader, int fd) {
+  reader->fd = fd;
+  reader->buffer = malloc(READER_BLOCK + 1);
+  reader->size = READER_BLOCK;
+  reader->start = 0;
+  reader->end = 0;
+  reader->eof = 0;
+  // Only a hint, and refused for pipes
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  return reader->buffer == NULL ? -1 : 0;
+}
+
+/*
+  Moves the part of a line left at the end of the buffer to its front and
+  reads until the buffer is full or the input ends. Every pointer readerLine
+  returned before is invalid afterwards. Returns 1 when there is more to
+  split, 0 at the end of the input and -1 on a read error.
+*/
+int readerFill(inputReader *reader) {
+  size_t left = reader->end - reader->start;
+
+  if (reader->eof) {
+    return left > 0;
+  }
+  if (reader->start == 0 && left == reader->size) {
+    // One line fills the buffer
+    char *bigger = realloc(reader->buffer, 2 * reader->size + 1);
+    if (bigger == NULL) {
+      return -1;
+    }
+    reader->buffer = bigger;
+    reader->size *= 2;
+  } else if (left > 0) {
+    memmove(reader->buffer, reader->buffer + reader->start, left);
+  }
+  reader->start = 0;
+  reader->end = left;
+
+  while (reader->end < reader->size) {
+    ssize_t n = read(reader->fd, reader->buffer + reader->end, reader->size - reader->end);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return -1;
+    }
+    if (n == 0) {
+      reader->eof = 1;
+      break;
+    }
+    reader->end += n;
+  }
+  return reader->end > 0;
+}
+
+/*
+  The next whole line in the buffer without its newline, NUL terminated in
+  place, or NULL when the buffer holds at most part of one and readerFill
+  is needed. At the end of the input a last line without a newline counts.
+*/
+char *readerLine(inputReader *reader, size_t *length) {
+  char *line = reader->buffer + reader->start;
+  size_t left = reader->end - reader->start;
+  char *newline = memchr(line, '\n', left);
+
+  if (newline == NULL) {
+    if (!reader->eof || left == 0) {
+      return NULL;
+    }
+    // The buffer has one byte to spare for this
+    newline = line + left;
+    reader->start = reader->end;
+  } else {
+    reader->start += newline - line + 1;
+  }
+  *newline = 0;
+  *length = newline - line;
+  return line;
+}
+
+void readerFree(inputReader *reader) {
+  free(reader->buffer);
+  reader->buffer = NULL;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stddef.h>
+
+/* Bytes read at a time; a longer line grows the buffer to fit it */
+#define READER_BLOCK (16 << 20)
+
+/*
+  Reads a file or pipe in large blocks into one buffer that is reused for
+  the whole input, so memory stays the same however large the input is.
+  Lines are split in place and handed out as pointers into the buffer,
+  which stay valid until the next readerFill.
+*/
+typedef struct inputReader {
+  int fd;
+  char *buffer;
+  size_t size;
+  size_t start;   // first byte not handed out yet
+  size_t end;     // bytes in the buffer
+  int eof;
+} inputReader;
+
+int readerInit(inputReader *reader, int fd);
+int readerFill(inputReader *reader);
+char *readerLine(inputReader *reader, size_t *length);
+void readerFree(inputReader *reader);
@@ -0,0 +1,170 @@
+#include "result.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void resetResult(tangleResult *result) {
+  result->status = CONWAY_OK;
+  result->classification = TANGLE_UNCLASSIFIED;
+  result->writhe = 0;
+  result->num = 0;
+  result->den = 0;
+  result->mirrorNum = 0;
+  result->mirrorDen = 0;
+  result->conwayLength = 0;
+  result->bigNum[0] = 0;
+  result->bigDen[0] = 0;
+  result->bigConway[0] = 0;
+  result->decomposition[0] = 0;
+  result->decompositionLength = 0;
+  result->truncated = 0;
+  result->crossingsRemoved = 0;
+  result->mergeAttempts = 0;
+  result->mergeAttemptsSaved = 0;
+#ifdef CONWAY_STATS
+  statsReset(&result->stats);
+#endif
+}
+
+/* printf into the decomposition text, marking the result truncated when full */
+void appendResult(tangleResult *result, const char *format, ...) {
+  int room = DECOMPOSITION_MAX - result->decompositionLength;
+  va_list args;
+
+  va_start(args, format);
+  int n = vsnprintf(result->decomposition + result->decompositionLength, room,
+                    format, args);
+  va_end(args);
+
+  if (n >= room) {
+    result->decompositionLength = DECOMPOSITION_MAX - 1;
+    result->truncated = 1;
+  } else if (n > 0) {
+    result->decompositionLength += n;
+  }
+}
+
+/*
+  Writes the Conway vector of a/b into terms[] in the order it is written out
+  and returns the number of terms. Each step takes A_i = a/b and continues with
+  b/r where r = a mod b; when the last remainder is 1 the expansion closes with
+  b, which comes first and is flagged through *closing.
+*/
+int conwayTerms(tangleInt a, tangleInt b, tangleInt terms[], int max, int *closing) {
+  tangleInt quotients[CONWAY_MAX];
+  int depth = 0;
+
+  *closing = 0;
+  if (b == 0) {
+    return 0;
+  }
+  while (depth < CONWAY_MAX) {
+    //through the fraction functions, so a reduction redone with big fractions can ask for them
+    quotients[depth++] = fractionDiv(a, b);
+    tangleInt r = fractionMod(a, b);
+    if (r < 0) {
+      r += b;  // a < 0 only for the pieces of a decomposition, never big
+    }
+    if (r > 1) {
+      a = b;
+      b = r;
+      continue;
+    }
+    if (r > 0) {
+      *closing = 1;
+    }
+    break;
+  }
+
+  int n = 0;
+  if (*closing && n < max) {
+    terms[n++] = b;
+  }
+  for (int i = depth - 1; i >= 0 && n < max; i--) {
+    terms[n++] = quotients[i];
+  }
+  return n;
+}
+
+/* Conway vector of a/b as text, e.g. "2 1 1 1 0" for 5/8 and " 2" for 2/1 */
+int formatConway(char *buf, int size, tangleInt a, tangleInt b) {
+  tangleInt terms[CONWAY_MAX];
+  int closing;
+  int n = conwayTerms(a, b, terms, CONWAY_MAX, &closing);
+  int len = 0;
+
+  buf[0] = 0;
+  for (int i = 0; i < n && len < size; i++) {
+    len += snprintf(buf + len, size - len, i == 0 && closing ? "%lld" : " %lld",
+                    terms[i]);
+  }
+  return len < size ? len : size - 1;
+}
+
+void appendConway(tangleResult *result, tangleInt a, tangleInt b) {
+  char text[CONWAY_TEXT_MAX];
+
+  formatConway(text, CONWAY_TEXT_MAX, a, b);
+  appendResult(result, "%s", text);
+}
+
+/* The fraction of a rational result, or of its mirror, as num/den */
+int formatFraction(char *buf, int size, const tangleResult *result, int mirror) {
+  if (result->bigNum[0] == 0) {
+    return snprintf(buf, size, "%lld/%lld", mirror ? result->mirrorNum : result->num,
+                    mirror ? result->mirrorDen : result->den);
+  }
+  const char *num = result->bigNum;
+  const char *sign = "";
+  if (mirror) {
+    if (*num == '-') {
+      num++;
+    } else {
+      sign = "-";
+    }
+  }
+  return snprintf(buf, size, "%s%s/%s", sign, num, result->bigDen);
+}
+
+/* The Conway vector of a rational result as formatConway writes it, without its sign */
+int formatResultConway(char *buf, int size, const tangleResult *result) {
+  if (result->bigNum[0] == 0) {
+    return formatConway(buf, size, llabs(result->num), result->den);
+  }
+  return snprintf(buf, size, "%s", result->bigConway);
+}
+
+/*
+  Writes the fields pdToConway has always produced for a tangle: the writhe,
+  then either the fraction and Conway vector of the tangle and of its mirror,
+  or the Montesinos/algebraic decomposition text.
+*/
+void printResult(FILE *out, const tangleResult *result) {
+  fprintf(out, "%d,", result->writhe);
+  if (result->status == CONWAY_OVERFLOW) {
+    fputs("Fraction overflow,", out);
+    return;
+  }
+  if (result->status == CONWAY_NO_MEMORY) {
+    fputs("Out of memory,", out);
+    return;
+  }
+  if (result->status == CONWAY_NOT_COPRIME) {
+    fputs("Fraction not in lowest terms,", out);
+    return;
+  }
+  if (result->classification != TANGLE_RATIONAL) {
+    fputs(result->decomposition, out);
+    return;
+  }
+
+  char conway[CONWAY_TEXT_MAX];
+  char fraction[2 * FRACTION_TEXT_MAX + 2];
+  int negative = result->bigNum[0] == 0 ? result->num < 0 : result->bigNum[0] == '-';
+  formatResultConway(conway, CONWAY_TEXT_MAX, result);
+  formatFraction(fraction, sizeof(fraction), result, 0);
+  fprintf(out, "%s,%c[%s],", fraction, negative ? '-' : ' ', conway);
+  formatFraction(fraction, sizeof(fraction), result, 1);
+  fprintf(out, "%s,%c[%s],", fraction, negative ? ' ' : '-', conway);
+}
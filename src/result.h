@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stdio.h>
+#include "fraction.h"
+#include "stats.h"
+
+#define CONWAY_MAX 128
+#define CONWAY_TEXT_MAX (CONWAY_MAX * 12)
+#define DECOMPOSITION_MAX 4096
+#define FRACTION_TEXT_MAX 512
+
+/*
+  Bumped whenever the reducer or writeResult changes what the result of some
+  tangle reads, so that results kept on disk by an older build are not
+  handed back as if this one had reduced them.
+*/
+#define CONWAY_RESULT_VERSION 3
+
+/* Status returned by pdToConwayResult */
+enum conwayStatus {
+  CONWAY_OK = 0,
+  CONWAY_NOT_MONTESINOS,  // makeCanonical found a piece that is an integer or zero tangle
+  CONWAY_NOT_ALGEBRAIC,   // orientAlgebraic could not attach a component
+  CONWAY_UNRESOLVED,      // more than two tangles remain that are not Montesinos
+  CONWAY_OVERFLOW,        // a fraction did not fit, even redone with arbitrary precision
+  CONWAY_NO_MEMORY,       // the scratch arena could not be allocated
+  CONWAY_NOT_COPRIME      // the last two tangles could not be summed, a fraction was not in lowest terms
+};
+
+/* What the reduction found the tangle to be */
+enum tangleClass {
+  TANGLE_UNCLASSIFIED = 0,
+  TANGLE_RATIONAL,
+  TANGLE_MONTESINOS,
+  TANGLE_ALGEBRAIC,
+  TANGLE_NON_ALGEBRAIC
+};
+
+/*
+  Everything pdToConway used to print for one tangle. Rational tangles fill
+  the fraction, its mirror and the Conway vector. Montesinos and algebraic
+  tangles keep the text of their decomposition, in the same layout the CSV
+  output has always used.
+*/
+typedef struct tangleResult {
+  int status;
+  int classification;
+  int writhe;
+  tangleInt num;
+  tangleInt den;
+  tangleInt mirrorNum;
+  tangleInt mirrorDen;
+  tangleInt conway[CONWAY_MAX];  // negated when num < 0, as in -[2 1 1]
+  int conwayLength;
+  /*
+    A fraction past tangleInt, from the reduction redone with arbitrary
+    precision: num and den in decimal, num with its sign, and the Conway
+    vector of |num|/den as formatConway writes it. num, den and the mirror
+    are 0 then. bigNum is empty for every other result.
+  */
+  char bigNum[FRACTION_TEXT_MAX];
+  char bigDen[FRACTION_TEXT_MAX];
+  char bigConway[CONWAY_TEXT_MAX];
+  char decomposition[DECOMPOSITION_MAX];
+  int decompositionLength;
+  int truncated;           // decomposition did not fit
+  int crossingsRemoved;    // by the Reidemeister I/II pass before merging
+  long mergeAttempts;      // merges tried by the sweeps in pdToConwayResult
+  long mergeAttemptsSaved; // merges a full sweep would also have tried
+#ifdef CONWAY_STATS
+  conwayStats stats;       // filled by pdToConwayArena, parse time by its caller
+#endif
+} tangleResult;
+
+void resetResult(tangleResult *result);
+void appendResult(tangleResult *result, const char *format, ...)
+  __attribute__((format(printf, 2, 3)));
+int conwayTerms(tangleInt a, tangleInt b, tangleInt terms[], int max, int *closing);
+int formatConway(char *buf, int size, tangleInt a, tangleInt b);
+void appendConway(tangleResult *result, tangleInt a, tangleInt b);
+int formatFraction(char *buf, int size, const tangleResult *result, int mirror);
+int formatResultConway(char *buf, int size, const tangleResult *result);
+void printResult(FILE *out, const tangleResult *result);
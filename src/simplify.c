@@ -0,0 +1,261 @@
+#include "simplify.h"
+#include "pdToConwayTangles.h"
+#include "util.h"
+
+/*
+  Reidemeister I and II moves run before any merging. A crossing with a kink,
+  an arc joining two neighbouring clocks of it, is removed and the strand
+  through it joined up. So are two crossings bounding a bigon that one strand
+  passes over at both ends. Each removal only puts the crossings it touched
+  back on the work list, so the pass is linear in the crossings.
+
+  A join keeps a tangle end's label, since the ends fix how the tangle sits,
+  and otherwise the smaller label. A move that would join two ends directly,
+  or close a strand into a loop without crossings, is left alone; such a
+  diagram cannot be written as rows of crossings.
+*/
+typedef struct simplifyState {
+  tangleInt (*pdCode)[7];
+  int (*edge)[4];
+  int *stack;
+  int *queued;
+  int depth;
+} simplifyState;
+
+size_t simplifyArenaSize(int rows){
+  return (size_t)(2 * rows + 2 * rows + 2) * sizeof(int) + 3 * ARENA_ALIGN;
+}
+
+static void push(simplifyState *s, int crossing){
+  if(!s->queued[crossing] && !isRemoved(s->pdCode, crossing)){
+    s->queued[crossing] = 1;
+    s->stack[s->depth++] = crossing;
+  }
+}
+
+/* The crossing at the other end of arc from i, or -9 */
+static int across(simplifyState *s, int arc, int i){
+  return s->edge[arc][0] == i ? s->edge[arc][2] : s->edge[arc][0];
+}
+
+/* The clock of arc at crossing j, which is one of its ends */
+static int clockAt(simplifyState *s, int arc, int j){
+  return s->edge[arc][0] == j ? s->edge[arc][1] : s->edge[arc][3];
+}
+
+/*
+  Whether crossing i has a kink, or neighbouring arcs p and q at clocks a and
+  a+1 that bound a face with one other crossing j and pass over, or under,
+  at both ends of the bigon. p and q bound a face only when they turn the
+  other way round j. Most twist crossings share two arcs with the next one
+  and are turned away here on the parity alone.
+*/
+static int reducible(simplifyState *s, int i){
+  tangleInt (*pdCode)[7] = s->pdCode;
+
+  for(int a = 0; a < 4; a++){
+    int p = pdCode[i][a];
+    int q = pdCode[i][(a + 1) % 4];
+    if(p == q){
+      return 1;
+    }
+    int j = across(s, p, i);
+    if(j < 0 || j == i || j != across(s, q, i)){
+      continue;
+    }
+    int pa = clockAt(s, p, j);
+    if((clockAt(s, q, j) + 1) % 4 == pa && a % 2 == pa % 2){
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* The end of arc at a crossing other than i and j, if it has one */
+static int farEnd(simplifyState *s, int arc, int i, int j, int *crossing, int *clock){
+  for(int end = 0; end < 4; end += 2){
+    int c = s->edge[arc][end];
+    if(c >= 0 && c != i && c != j){
+      *crossing = c;
+      *clock = s->edge[arc][end + 1];
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* Whether x and y could be joined once crossings i and j are gone */
+static int joinable(simplifyState *s, int x, int y, int i, int j){
+  int c, k;
+  return farEnd(s, x, i, j, &c, &k) || farEnd(s, y, i, j, &c, &k);
+}
+
+/* Joins arcs x and y, which met at the removed crossings i and j, into one arc */
+static void joinArcs(simplifyState *s, int x, int y, int i, int j){
+  int xc = -9, xk = -9, yc = -9, yk = -9;
+  int xLive = farEnd(s, x, i, j, &xc, &xk);
+  int yLive = farEnd(s, y, i, j, &yc, &yk);
+
+  //an arc with no other end is an end of the tangle
+  if(xLive && (!yLive || y < x)){
+    int t = x; x = y; y = t;
+    t = xc; xc = yc; yc = t;
+    t = xk; xk = yk; yk = t;
+    t = xLive; xLive = yLive; yLive = t;
+  }
+  //x is kept and y, which has a far end, is dropped
+  s->pdCode[yc][yk] = x;
+  s->edge[x][0] = xLive ? xc : yc;
+  s->edge[x][1] = xLive ? xk : yk;
+  s->edge[x][2] = xLive ? yc : -9;
+  s->edge[x][3] = xLive ? yk : -9;
+  for(int k = 0; k < 4; k++){
+    s->edge[y][k] = -9;
+  }
+  push(s, yc);
+  if(xLive){
+    push(s, xc);
+  }
+}
+
+static void removeCrossing(simplifyState *s, int crossing){
+  s->pdCode[crossing][4] = 0;
+  s->pdCode[crossing][5] = 0;
+}
+
+static void dropArc(simplifyState *s, int arc){
+  for(int k = 0; k < 4; k++){
+    s->edge[arc][k] = -9;
+  }
+}
+
+/* Removes a kink at crossing i, returning the crossings removed */
+static int removeKink(simplifyState *s, int i){
+  tangleInt (*pdCode)[7] = s->pdCode;
+
+  for(int a = 0; a < 4; a++){
+    int loop = pdCode[i][a];
+    int x = pdCode[i][(a + 2) % 4];
+    int y = pdCode[i][(a + 3) % 4];
+    if(loop != pdCode[i][(a + 1) % 4] || x == y || !joinable(s, x, y, i, i)){
+      continue;
+    }
+    removeCrossing(s, i);
+    joinArcs(s, x, y, i, i);
+    dropArc(s, loop);
+    return 1;
+  }
+  return 0;
+}
+
+/* Removes crossing i and the crossing it bounds a removable bigon with, returning the crossings removed */
+static int removeBigon(simplifyState *s, int i){
+  tangleInt (*pdCode)[7] = s->pdCode;
+
+  for(int a = 0; a < 4; a++){
+    int b = (a + 1) % 4;
+    int p = pdCode[i][a];
+    int q = pdCode[i][b];
+    int j, pa, jq, qb;
+    if(p == q || !farEnd(s, p, i, i, &j, &pa) || !farEnd(s, q, i, i, &jq, &qb) || j != jq){
+      continue;
+    }
+    //see reducible
+    if((qb + 1) % 4 != pa || a % 2 != pa % 2){
+      continue;
+    }
+    int x1 = pdCode[i][(a + 2) % 4];
+    int y1 = pdCode[i][(b + 2) % 4];
+    int x2 = pdCode[j][(pa + 2) % 4];
+    int y2 = pdCode[j][(qb + 2) % 4];
+    //a shared arc means another kink or bigon between the same crossings
+    if(x1 == y1 || x1 == x2 || x1 == y2 || y1 == x2 || y1 == y2 || x2 == y2 ||
+       !joinable(s, x1, x2, i, j) || !joinable(s, y1, y2, i, j)){
+      continue;
+    }
+    removeCrossing(s, i);
+    removeCrossing(s, j);
+    joinArcs(s, x1, x2, i, j);
+    joinArcs(s, y1, y2, i, j);
+    dropArc(s, p);
+    dropArc(s, q);
+    return 2;
+  }
+  return 0;
+}
+
+static int reduceCrossing(simplifyState *s, int i){
+  if(isRemoved(s->pdCode, i) || !reducible(s, i)){
+    return 0;
+  }
+  int gone = removeKink(s, i);
+  return gone ? gone : removeBigon(s, i);
+}
+
+/*
+  Removes the kinks and removable bigons of the tangle in pdCode, whose edge
+  matrix is current, then slides the rows left up, renumbers the arcs in the
+  same order and rebuilds edge. *rows is updated and the number of crossings
+  removed returned, or -1 when scratch ran out before anything was removed.
+*/
+int simplifyDiagram(int *rows, tangleInt pdCode[][7], int edge[][4], arena *scratch){
+  int n = *rows;
+  simplifyState s = {pdCode, edge, arenaAlloc(scratch, n * sizeof(int)),
+                     arenaAlloc(scratch, n * sizeof(int)), 0};
+  int *label = arenaAlloc(scratch, (2 * n + 2) * sizeof(int));
+  int removed = 0;
+
+  if(s.stack == NULL || s.queued == NULL || label == NULL){
+    return -1;
+  }
+  for(int i = 0; i < n; i++){
+    s.queued[i] = 0;
+  }
+  //one sweep, going back only to crossings a removal touched
+  for(int i = 0; i < n; i++){
+    removed += reduceCrossing(&s, i);
+    while(s.depth > 0){
+      int crossing = s.stack[--s.depth];
+      s.queued[crossing] = 0;
+      removed += reduceCrossing(&s, crossing);
+    }
+  }
+  if(removed == 0){
+    return 0;
+  }
+
+  int live = 0;
+  for(int i = 0; i < n; i++){
+    if(!isRemoved(pdCode, i)){
+      for(int k = 0; k < 7; k++){
+        pdCode[live][k] = pdCode[i][k];
+      }
+      live++;
+    }
+  }
+  for(int l = 0; l < 2 * n + 2; l++){
+    label[l] = -1;
+  }
+  for(int i = 0; i < live; i++){
+    for(int k = 0; k < 4; k++){
+      label[pdCode[i][k]] = 0;
+    }
+  }
+  int next = 0;
+  for(int l = 0; l < 2 * n + 2; l++){
+    if(label[l] == 0){
+      label[l] = next++;
+    }
+  }
+  if(next != 2 * live + 2){
+    DEBUG_PRINTF("simplify left %d labels on %d crossings\n", next, live);
+  }
+  for(int i = 0; i < live; i++){
+    for(int k = 0; k < 4; k++){
+      pdCode[i][k] = label[pdCode[i][k]];
+    }
+  }
+  createEdge(live, pdCode, edge);
+  *rows = live;
+  return removed;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "arena.h"
+#include "fraction.h"
+
+size_t simplifyArenaSize(int rows);
+int simplifyDiagram(int *rows, tangleInt pdCode[][7], int edge[][4], arena *scratch);
@@ -0,0 +1,59 @@
+#include "stats.h"
+
+#ifdef CONWAY_STATS
+_Thread_local conwayStats *activeStats;
+#endif
+
+const char *stageNames[STAGES] = {
+  "parse", "createEdge", "writhe", "simplify", "horV", "rationalSimple", "remove",
+  "sort", "orientAlgebraic", "algTangle"
+};
+
+void statsReset(conwayStats *stats) {
+  for (int s = 0; s < STAGES; s++) {
+    stats->stageNanos[s] = 0;
+  }
+  stats->mark = 0;
+  stats->horVAttempts = 0;
+  stats->horVMerges = 0;
+  stats->rationalAttempts = 0;
+  stats->rationalMerges = 0;
+  stats->rotations = 0;
+  stats->tangleSwaps = 0;
+  stats->rowsCompacted = 0;
+  stats->crossingsRemoved = 0;
+  stats->edgeRowsScanned = 0;
+}
+
+void statsAdd(conwayStats *total, const conwayStats *stats) {
+  for (int s = 0; s < STAGES; s++) {
+    total->stageNanos[s] += stats->stageNanos[s];
+  }
+  total->horVAttempts += stats->horVAttempts;
+  total->horVMerges += stats->horVMerges;
+  total->rationalAttempts += stats->rationalAttempts;
+  total->rationalMerges += stats->rationalMerges;
+  total->rotations += stats->rotations;
+  total->tangleSwaps += stats->tangleSwaps;
+  total->rowsCompacted += stats->rowsCompacted;
+  total->crossingsRemoved += stats->crossingsRemoved;
+  total->edgeRowsScanned += stats->edgeRowsScanned;
+}
+
+/* Writes the fields of stats as JSON members, without the enclosing braces */
+void statsJSON(FILE *out, const conwayStats *stats) {
+  long long total = 0;
+
+  fprintf(out, "\"ns\":{");
+  for (int s = 0; s < STAGES; s++) {
+    fprintf(out, "\"%s\":%lld,", stageNames[s], stats->stageNanos[s]);
+    total += stats->stageNanos[s];
+  }
+  fprintf(out, "\"total\":%lld},", total);
+  fprintf(out, "\"horV\":{\"attempts\":%ld,\"merges\":%ld},", stats->horVAttempts, stats->horVMerges);
+  fprintf(out, "\"rationalSimple\":{\"attempts\":%ld,\"merges\":%ld},",
+          stats->rationalAttempts, stats->rationalMerges);
+  fprintf(out, "\"rotations\":%ld,\"tangleSwaps\":%ld,\"rowsCompacted\":%ld,\"crossingsRemoved\":%ld,"
+          "\"edgeRowsScanned\":%ld", stats->rotations, stats->tangleSwaps, stats->rowsCompacted,
+          stats->crossingsRemoved, stats->edgeRowsScanned);
+}
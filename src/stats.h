@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdio.h>
+#include <time.h>
+
+/*
+  Instrumentation of the reduction. Built with -DCONWAY_STATS (make STATS=1)
+  pdToConwayArena records into its result how long each stage took and how
+  much work it did; otherwise every hook below compiles to nothing.
+*/
+enum conwayStage {
+  STAGE_PARSE,            // parsePD, timed by the caller
+  STAGE_CREATE_EDGE,
+  STAGE_WRITHE,
+  STAGE_SIMPLIFY,         // simplifyDiagram
+  STAGE_HOR_V,            // the makeHorVtangle sweeps
+  STAGE_RATIONAL_SIMPLE,  // the makeRationalSimple sweeps
+  STAGE_REMOVE,           // removeTangles, and addRationalTangles between
+  STAGE_SORT,             // algTangle's sort
+  STAGE_ORIENT,           // orientAlgebraic
+  STAGE_ALGEBRAIC,        // the rest of algTangle
+  STAGES
+};
+
+typedef struct conwayStats {
+  long long stageNanos[STAGES];
+  long long mark;          // when the stage being timed began
+  long horVAttempts;
+  long horVMerges;
+  long rationalAttempts;
+  long rationalMerges;
+  long rotations;          // tangles turned by 90 degrees or more
+  long tangleSwaps;        // pairs of rows exchanged by sort and orientAlgebraic
+  long rowsCompacted;      // rows removeTangles slid over removed ones
+  long crossingsRemoved;   // by simplifyDiagram
+  long edgeRowsScanned;    // edge rows read or rewritten
+} conwayStats;
+
+extern const char *stageNames[STAGES];
+
+static inline long long statsClock(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void statsReset(conwayStats *stats);
+void statsAdd(conwayStats *total, const conwayStats *stats);
+void statsJSON(FILE *out, const conwayStats *stats);
+
+#ifdef CONWAY_STATS
+/* The stats of the reduction running on this thread, NULL between reductions */
+extern _Thread_local conwayStats *activeStats;
+
+#define STATS_ATTACH(stats) (activeStats = (stats), activeStats->mark = statsClock())
+#define STATS_DETACH() (activeStats = NULL)
+#define STAT_ADD(field, n) do { \
+    if (activeStats != NULL) activeStats->field += (n); \
+  } while (0)
+/* Charges the time since the last mark to stage */
+#define STAGE_END(stage) do { \
+    if (activeStats != NULL) { \
+      long long now_ = statsClock(); \
+      activeStats->stageNanos[stage] += now_ - activeStats->mark; \
+      activeStats->mark = now_; \
+    } \
+  } while (0)
+#else
+#define STATS_ATTACH(stats) ((void)(stats))
+#define STATS_DETACH() do {} while (0)
+#define STAT_ADD(field, n) do {} while (0)
+#define STAGE_END(stage) do {} while (0)
+#endif
@@ -0,0 +1,198 @@
+#include "store.h"
+#include "result.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static size_t storeFileSize(uint64_t slots, uint64_t dataSize) {
+  return sizeof(storeHeader) + slots * sizeof(storeSlot) + dataSize;
+}
+
+/*
+  Opens the store at path, creating it with room for slots results and
+  dataSize bytes of rows when it does not exist yet; an existing store keeps
+  the sizes it was made with. The file is sparse, so only what is written
+  takes disk space. Returns 0, or -1 with errno set: EINVAL when path is not
+  a result store, ESTALE when its results came from a build with another
+  CONWAY_RESULT_VERSION.
+*/
+int storeOpen(resultStore *store, const char *path, uint64_t slots, uint64_t dataSize) {
+  struct stat st;
+
+  store->fd = open(path, O_RDWR | O_CREAT, 0644);
+  if (store->fd < 0) {
+    return -1;
+  }
+  // Only one process sets up a new file
+  flock(store->fd, LOCK_EX);
+  if (fstat(store->fd, &st) != 0) {
+    goto fail;
+  }
+  if (st.st_size == 0) {
+    storeHeader header;
+    uint64_t size = 1;
+    while (size < slots) {
+      size *= 2;
+    }
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, STORE_MAGIC, 8);
+    header.resultVersion = CONWAY_RESULT_VERSION;
+    header.slots = size;
+    header.dataSize = dataSize;
+    if (ftruncate(store->fd, storeFileSize(size, dataSize)) != 0 ||
+        pwrite(store->fd, &header, sizeof(header), 0) != sizeof(header)) {
+      goto fail;
+    }
+  } else {
+    storeHeader header;
+    if (pread(store->fd, &header, sizeof(header), 0) != sizeof(header) ||
+        memcmp(header.magic, STORE_MAGIC, 8) != 0 || header.slots == 0 ||
+        (header.slots & (header.slots - 1)) != 0 || header.dataUsed > header.dataSize ||
+        (off_t)storeFileSize(header.slots, header.dataSize) != st.st_size) {
+      errno = EINVAL;  // not a result store
+      goto fail;
+    }
+    if (header.resultVersion != CONWAY_RESULT_VERSION) {
+      errno = ESTALE;
+      goto fail;
+    }
+  }
+  flock(store->fd, LOCK_UN);
+
+  if (fstat(store->fd, &st) != 0) {
+    goto fail;
+  }
+  store->mapSize = st.st_size;
+  store->map = mmap(NULL, store->mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, store->fd, 0);
+  if (store->map == MAP_FAILED) {
+    goto fail;
+  }
+  store->header = (storeHeader *)store->map;
+  store->slots = (storeSlot *)(store->map + sizeof(storeHeader));
+  store->data = store->map + sizeof(storeHeader) + store->header->slots * sizeof(storeSlot);
+  pthread_mutex_init(&store->lock, NULL);
+  return 0;
+
+fail:
+  close(store->fd);
+  return -1;
+}
+
+/* perror for a storeOpen that failed, saying what a stale store needs */
+void storePerror(const char *path) {
+  if (errno == ESTALE) {
+    fprintf(stderr, "%s: results of another version of the reducer, remove it to start over\n", path);
+  } else {
+    perror(path);
+  }
+}
+
+/* Slot holding key, or the empty slot where it would go */
+static storeSlot *storeSlotFor(resultStore *store, const uint64_t key[2]) {
+  uint64_t mask = store->header->slots - 1;
+  uint64_t i = key[0] & mask;
+  while (1) {
+    storeSlot *slot = &store->slots[i];
+    if (__atomic_load_n(&slot->length, __ATOMIC_ACQUIRE) == 0 ||
+        (slot->key[0] == key[0] && slot->key[1] == key[1])) {
+      return slot;
+    }
+    i = (i + 1) & mask;
+  }
+}
+
+/* The row stored for key and its length, or NULL; needs no lock since slots are published whole */
+const char *storeLookup(resultStore *store, const uint64_t key[2], size_t *length) {
+  storeSlot *slot = storeSlotFor(store, key);
+  *length = __atomic_load_n(&slot->length, __ATOMIC_ACQUIRE);
+  if (*length == 0) {
+    return NULL;
+  }
+  return store->data + slot->offset;
+}
+
+/*
+  Appends text[0..length) as the row for key unless the key is already
+  there. Threads of this process take the mutex and other processes are
+  kept out with flock. The row is written before its slot, and the slot's
+  length last, so a reader never sees half an entry. Returns 0, or -1 when
+  the store is full and needs compacting into a larger one.
+*/
+int storeInsert(resultStore *store, const uint64_t key[2], const char *text, size_t length) {
+  storeHeader *header = store->header;
+  int status = 0;
+
+  pthread_mutex_lock(&store->lock);
+  flock(store->fd, LOCK_EX);
+  storeSlot *slot = storeSlotFor(store, key);
+  if (slot->length == 0) {
+    if (4 * (header->entries + 1) > 3 * header->slots ||
+        header->dataUsed + length + 1 > header->dataSize) {
+      status = -1;
+    } else {
+      memcpy(store->data + header->dataUsed, text, length);
+      store->data[header->dataUsed + length] = 0;
+      slot->key[0] = key[0];
+      slot->key[1] = key[1];
+      slot->offset = header->dataUsed;
+      header->dataUsed += length + 1;
+      header->entries++;
+      __atomic_store_n(&slot->length, (uint32_t)length, __ATOMIC_RELEASE);
+    }
+  }
+  flock(store->fd, LOCK_UN);
+  pthread_mutex_unlock(&store->lock);
+  return status;
+}
+
+void storeClose(resultStore *store) {
+  munmap(store->map, store->mapSize);
+  close(store->fd);
+  pthread_mutex_destroy(&store->lock);
+}
+
+/*
+  Copies every result of the store at from into a new store at to with the
+  given sizes (0 keeps the old one), packing the rows and dropping any left
+  behind by a run that stopped mid insert. Returns 0, or -1 on failure.
+*/
+int storeCompact(const char *from, const char *to, uint64_t slots, uint64_t dataSize) {
+  resultStore old, new;
+
+  // storeOpen would create an empty store in its place
+  if (access(from, F_OK) != 0 || storeOpen(&old, from, 0, 0) != 0) {
+    storePerror(from);
+    return -1;
+  }
+  if (slots == 0) {
+    slots = old.header->slots;
+  }
+  if (dataSize == 0) {
+    dataSize = old.header->dataSize;
+  }
+  unlink(to);
+  if (storeOpen(&new, to, slots, dataSize) != 0) {
+    storePerror(to);
+    storeClose(&old);
+    return -1;
+  }
+
+  int status = 0;
+  for (uint64_t i = 0; i < old.header->slots && status == 0; i++) {
+    storeSlot *slot = &old.slots[i];
+    if (slot->length != 0) {
+      status = storeInsert(&new, slot->key, old.data + slot->offset, slot->length);
+    }
+  }
+  if (status != 0) {
+    fprintf(stderr, "%s: too small for the results in %s\n", to, from);
+  }
+  storeClose(&new);
+  storeClose(&old);
+  return status;
+}
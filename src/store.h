@@ -0,0 +1,47 @@
+#pragma once
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  Results kept on disk between runs, keyed like the in-process cache on the
+  hash of the canonical PD code. The file is a header, an open-addressing
+  table of slots and an append-only area of result rows, all mapped shared,
+  so any number of threads and processes can look results up without locks.
+*/
+#define STORE_MAGIC "PDCSTOR2"
+
+typedef struct storeHeader {
+  char magic[8];
+  uint32_t resultVersion;  // CONWAY_RESULT_VERSION of the build that made the store
+  uint32_t reserved;
+  uint64_t slots;      // a power of two
+  uint64_t dataSize;   // bytes in the data area
+  uint64_t dataUsed;
+  uint64_t entries;
+} storeHeader;
+
+typedef struct storeSlot {
+  uint64_t key[2];
+  uint64_t offset;     // of the row in the data area
+  uint32_t length;     // of the row without its NUL, 0 for an empty slot; written last
+  uint32_t reserved;
+} storeSlot;
+
+typedef struct resultStore {
+  int fd;
+  char *map;
+  size_t mapSize;
+  storeHeader *header;
+  storeSlot *slots;
+  char *data;
+  pthread_mutex_t lock;
+} resultStore;
+
+int storeOpen(resultStore *store, const char *path, uint64_t slots, uint64_t dataSize);
+void storePerror(const char *path);
+const char *storeLookup(resultStore *store, const uint64_t key[2], size_t *length);
+int storeInsert(resultStore *store, const uint64_t key[2], const char *text, size_t length);
+void storeClose(resultStore *store);
+int storeCompact(const char *from, const char *to, uint64_t slots, uint64_t dataSize);
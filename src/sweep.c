@@ -0,0 +1,305 @@
+#include "sweep.h"
+#include "generate.h"
+#include "output.h"
+#include "pdToConwayTangles.h"
+#include "util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SHAPES 3
+#define CLASSES 5
+
+/* Reduces each enumerated tangle as it comes, reusing one arena throughout */
+typedef struct sweepState {
+  arena scratch;
+  tangleResult result;
+  long tangles;
+  long failed[SHAPES];
+  long classes[SHAPES][CLASSES];
+  long closures[SHAPES];
+  long unrecognized[SHAPES];
+  long wrongClass[SHAPES];
+  long wrongValue[SHAPES];
+} sweepState;
+
+/* A fraction with den > 0 and no common factor, or 1/0 */
+typedef struct sweepFraction {
+  tangleInt num;
+  tangleInt den;
+} sweepFraction;
+
+static sweepFraction makeFraction(tangleInt num, tangleInt den) {
+  tangleInt x, y;
+  tangleInt g = bezout(num, den, &x, &y);
+  sweepFraction f = {num, den};
+
+  if (g > 1) {
+    f.num /= g;
+    f.den /= g;
+  }
+  if (f.den < 0 || (f.den == 0 && f.num < 0)) {
+    f.num = -f.num;
+    f.den = -f.den;
+  }
+  return f;
+}
+
+/* The fraction of a Conway vector "[a1 .. an]", an + 1/(a(n-1) + ...), and the text after it; NULL if there is none */
+static const char *vectorFraction(const char *c, sweepFraction *f) {
+  char *end;
+
+  if (*c++ != '[') {
+    return NULL;
+  }
+  f->num = strtoll(c, &end, 10);
+  f->den = 1;
+  while (end != c) {
+    c = end;
+    tangleInt term = strtoll(c, &end, 10);
+    if (end != c) {
+      *f = makeFraction(term * f->num + f->den, f->num);
+    }
+  }
+  return *c == ']' ? c + 1 : NULL;
+}
+
+/* The pieces of the sum a tangle of SHAPE_SUM or SHAPE_PRODUCT is, taken from its name; -1 if it has none */
+static int expectedPieces(const char *name, int shape, sweepFraction pieces[], int max) {
+  int count = 0;
+
+  while (*name != 0 && count < max) {
+    sweepFraction f;
+    name = vectorFraction(name, &f);
+    if (name == NULL) {
+      return -1;
+    }
+    //a product is a sum turned 90 degrees, which turns each piece x to -1/x
+    pieces[count++] = shape == SHAPE_PRODUCT ? makeFraction(-f.den, f.num) : f;
+    if (*name == '+' || *name == '*') {
+      name++;
+    }
+  }
+  return *name == 0 ? count : -1;
+}
+
+/* The pieces of a Montesinos result, N(a/b + c/d + ...) at the start of its decomposition; -1 if it is not that */
+static int resultPieces(const tangleResult *result, sweepFraction pieces[], int max) {
+  const char *c = result->decomposition;
+  int count = 0;
+  int used;
+  long long num, den;
+
+  if (strncmp(c, "N(", 2) != 0) {
+    return -1;
+  }
+  c += 2;
+  while (count < max && sscanf(c, "%lld/%lld%n", &num, &den, &used) == 2) {
+    pieces[count++] = makeFraction(num, den);
+    c += used;
+    if (*c == ')') {
+      return count;
+    }
+    used = 0;
+    sscanf(c, " + %n", &used);
+    if (used == 0) {
+      return -1;
+    }
+    c += used;
+  }
+  return -1;
+}
+
+static int compareFractions(const void *a, const void *b) {
+  const sweepFraction *x = a, *y = b;
+  if (x->den != y->den) {
+    return x->den < y->den ? -1 : 1;
+  }
+  return x->num < y->num ? -1 : x->num > y->num;
+}
+
+/*
+  Whether two sums of rational tangles are the same Montesinos tangle, as
+  far as the invariants flypes and moving twists between pieces keep tell:
+  the total of the pieces and, of those that are not integers, the parts
+  past the integer, in any order. Pieces is sorted in place.
+*/
+static int sameMontesinos(sweepFraction a[], int aCount, sweepFraction b[], int bCount) {
+  sweepFraction total[2] = {{0, 1}, {0, 1}};
+  sweepFraction *pieces[2] = {a, b};
+  int counts[2] = {aCount, bCount};
+  int kept[2] = {0, 0};
+  int overflow = 0;
+
+  for (int s = 0; s < 2; s++) {
+    for (int i = 0; i < counts[s]; i++) {
+      sweepFraction f = pieces[s][i];
+      if (f.den == 0) {
+        return 0;
+      }
+      total[s] = makeFraction(fractionAdd(fractionMul(total[s].num, f.den, &overflow),
+                                          fractionMul(f.num, total[s].den, &overflow), &overflow),
+                              fractionMul(total[s].den, f.den, &overflow));
+      if (f.den > 1) {
+        pieces[s][kept[s]].num = (f.num % f.den + f.den) % f.den;
+        pieces[s][kept[s]++].den = f.den;
+      }
+    }
+    qsort(pieces[s], kept[s], sizeof(sweepFraction), compareFractions);
+  }
+  if (overflow) {
+    return 1;  // too large to tell, so not counted as wrong
+  }
+  if (total[0].num != total[1].num || total[0].den != total[1].den || kept[0] != kept[1]) {
+    return 0;
+  }
+  for (int i = 0; i < kept[0]; i++) {
+    if (compareFractions(&a[i], &b[i]) != 0) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/*
+  The determinant of N(a/b + c/d + ...), |a*d*... + b*c*...|, which any
+  rational tangle with the same closure has as its numerator; -1 if it
+  does not fit.
+*/
+static tangleInt closureDeterminant(sweepFraction pieces[], int count) {
+  tangleInt sum = 0;
+  int overflow = 0;
+
+  for (int i = 0; i < count; i++) {
+    tangleInt term = pieces[i].num;
+    for (int j = 0; j < count; j++) {
+      if (j != i) {
+        term = fractionMul(term, pieces[j].den, &overflow);
+      }
+    }
+    sum = fractionAdd(sum, term, &overflow);
+  }
+  if (overflow) {
+    return -1;
+  }
+  return sum < 0 ? -sum : sum;
+}
+
+/*
+  Whether a sum or product reduced as rational is the known shortfall of
+  addRationalTangles (see src/TODO.txt): the rational tangle it reports
+  closes, on one side or the other, to the same link as the pieces the
+  tangle was built from.
+*/
+static int rationalClosure(const tangleResult *result, const char *name, int shape, int rows) {
+  sweepFraction built[rows];
+  int count = expectedPieces(name, shape, built, rows);
+  tangleInt determinant = count < 0 ? -1 : closureDeterminant(built, count);
+
+  return determinant >= 0 && (llabs(result->num) == determinant || llabs(result->den) == determinant);
+}
+
+/*
+  Checks the result of an enumerated tangle against the expression it was
+  built from, reporting a mismatch on stderr. None of them is rational, as
+  every node has two children that are not twists. Sums and products of
+  rational tangles are Montesinos tangles, and must come out as the same
+  pieces up to flypes and twists; the others, which nest sums in products,
+  are algebraic. Two shortfalls are counted apart from the wrong results:
+  a sum or product reduced as a rational tangle with the same closure,
+  and one only found to be algebraic, which it is.
+*/
+static void checkTangle(sweepState *sweep, const char *name, int shape, int rows){
+  const tangleResult *result = &sweep->result;
+  int expected = shape == SHAPE_NESTED ? TANGLE_ALGEBRAIC : TANGLE_MONTESINOS;
+
+  if(result->classification != expected){
+    const char *known = "";
+    if(expected == TANGLE_MONTESINOS && result->classification == TANGLE_ALGEBRAIC){
+      sweep->unrecognized[shape]++;
+      known = " (not recognized as Montesinos)";
+    } else if(expected == TANGLE_MONTESINOS && result->classification == TANGLE_RATIONAL &&
+              rationalClosure(result, name, shape, rows)){
+      sweep->closures[shape]++;
+      known = " (same closure, see src/TODO.txt)";
+    } else {
+      sweep->wrongClass[shape]++;
+    }
+    fprintf(stderr, "%ld %s: %s expected, reduced as %s", sweep->tangles, name,
+            className(expected), className(result->classification));
+    if(result->classification == TANGLE_RATIONAL){
+      fprintf(stderr, " %lld/%lld", result->num, result->den);
+    }
+    fprintf(stderr, "%s\n", known);
+    return;
+  }
+  if(shape == SHAPE_NESTED){
+    return;
+  }
+  sweepFraction built[rows], reduced[rows];
+  int builtCount = expectedPieces(name, shape, built, rows);
+  int reducedCount = resultPieces(result, reduced, rows);
+  if(builtCount < 0 || reducedCount < 0 || !sameMontesinos(built, builtCount, reduced, reducedCount)){
+    sweep->wrongValue[shape]++;
+    fprintf(stderr, "%ld %s: reduced as %.*s\n", sweep->tangles, name,
+            (int)strcspn(result->decomposition, ","), result->decomposition);
+  }
+}
+
+static void sweepTangle(void *context, const char *name, int shape, int rows, tangleInt pdCode[][7]){
+  sweepState *sweep = context;
+
+  pdToConwayArena(rows, pdCode, &sweep->result, &sweep->scratch);
+  writePrefix(stdout, FORMAT_CSV, sweep->tangles + 1, name, "?");
+  writeResult(stdout, FORMAT_CSV, &sweep->result);
+  sweep->tangles++;
+  if(sweep->result.status != CONWAY_OK){
+    sweep->failed[shape]++;
+  } else {
+    sweep->classes[shape][sweep->result.classification]++;
+    checkTangle(sweep, name, shape, rows);
+  }
+}
+
+/*
+  Enumerates the algebraic tangles up to maxCrossings and reduces each one
+  in this process, writing the same CSV rows batch mode does with the
+  tangle's sums and products in place of its Conway vector. Each result is
+  checked against the expression the tangle was built from, and every
+  mismatch, then how each shape of tangle was classified, is reported on
+  stderr, so a sweep shows at a glance where the reducer falls short.
+  Returns 1 when a tangle was reduced to something it is not, leaving out
+  the two known shortfalls checkTangle counts apart.
+*/
+int runSweep(int maxCrossings){
+  static const char *shapes[SHAPES] = {"sums", "products", "nested"};
+  sweepState sweep = {0};
+  struct timespec begin, end;
+
+  arenaInit(&sweep.scratch);
+  clock_gettime(CLOCK_MONOTONIC, &begin);
+  long records = generateAlgebraic(maxCrossings, sweepTangle, &sweep);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  arenaFree(&sweep.scratch);
+  if(records < 0){
+    perror("generateAlgebraic");
+    return 1;
+  }
+
+  double seconds = (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9;
+  fprintf(stderr, "%ld tangles in %.3f s, %.0f tangles/sec\n",
+          sweep.tangles, seconds, seconds > 0 ? sweep.tangles / seconds : 0.0);
+  long wrong = 0;
+  for(int s = 0; s < SHAPES; s++){
+    fprintf(stderr, "%s: %ld rational, %ld Montesinos, %ld algebraic, %ld non-algebraic, "
+            "%ld unclassified, %ld failed; %ld rational with the same closure, %ld not recognized, "
+            "%ld of the wrong class, %ld with the wrong pieces\n",
+            shapes[s], sweep.classes[s][TANGLE_RATIONAL], sweep.classes[s][TANGLE_MONTESINOS],
+            sweep.classes[s][TANGLE_ALGEBRAIC], sweep.classes[s][TANGLE_NON_ALGEBRAIC],
+            sweep.classes[s][TANGLE_UNCLASSIFIED], sweep.failed[s], sweep.closures[s],
+            sweep.unrecognized[s], sweep.wrongClass[s], sweep.wrongValue[s]);
+    wrong += sweep.wrongClass[s] + sweep.wrongValue[s];
+  }
+  return wrong > 0;
+}
@@ -0,0 +1,55 @@
+#include "trace.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef CONWAY_TRACE
+_Thread_local traceRing *activeTrace;
+#endif
+
+/* Returns 0, or -1 when the events cannot be allocated */
+int traceInit(traceRing *ring) {
+  ring->events = malloc(TRACE_RING_EVENTS * sizeof(traceEvent));
+  ring->head = 0;
+  ring->label = 0;
+  return ring->events == NULL ? -1 : 0;
+}
+
+void traceFree(traceRing *ring) {
+  free(ring->events);
+  ring->events = NULL;
+}
+
+/* Writes count rings to out, each oldest event first. Returns 0, or -1 on a write error */
+int traceWrite(FILE *out, const traceRing rings[], int count) {
+  traceFileHeader header;
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, TRACE_MAGIC, 8);
+  header.version = TRACE_VERSION;
+  header.rings = count;
+  if (fwrite(&header, sizeof(header), 1, out) != 1) {
+    return -1;
+  }
+  for (int r = 0; r < count; r++) {
+    const traceRing *ring = &rings[r];
+    traceRingHeader ringHeader;
+    uint64_t kept = ring->head < TRACE_RING_EVENTS ? ring->head : TRACE_RING_EVENTS;
+    uint64_t first = ring->head - kept;
+
+    ringHeader.ring = r;
+    ringHeader.eventSize = sizeof(traceEvent);
+    ringHeader.recorded = ring->head;
+    ringHeader.count = kept;
+    if (fwrite(&ringHeader, sizeof(ringHeader), 1, out) != 1) {
+      return -1;
+    }
+    // The oldest event sits at head once the ring has wrapped, so up to two runs
+    uint64_t start = first & (TRACE_RING_EVENTS - 1);
+    uint64_t run = kept < TRACE_RING_EVENTS - start ? kept : TRACE_RING_EVENTS - start;
+    if (fwrite(ring->events + start, sizeof(traceEvent), run, out) != run ||
+        fwrite(ring->events, sizeof(traceEvent), kept - run, out) != kept - run) {
+      return -1;
+    }
+  }
+  return fflush(out) == 0 ? 0 : -1;
+}
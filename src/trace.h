@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include "fraction.h"
+
+/*
+  A flight recorder for the reduction. Built with -DCONWAY_TRACE (make
+  TRACE=1) every merge, rotation, swap and removal is written as a fixed size
+  event into a ring attached to the thread, which keeps the latest
+  TRACE_RING_EVENTS of them at no more cost than a few stores each.
+  traceWrite saves rings to a file for tools/traceDecode to print; without
+  the flag the hooks compile to nothing.
+*/
+#define TRACE_MAGIC "PDCTRACE"
+#define TRACE_VERSION 1
+#define TRACE_RING_EVENTS (1 << 16)   // a power of two
+
+enum traceKind {
+  TRACE_BEGIN,   // a reduction starts: tangleA crossings, num the ring's label
+  TRACE_MERGE,   // tangleA absorbed into tangleB along clocks, giving num/den
+  TRACE_ROTATE,  // tangleA turned clock1 quarters CCW, its fraction num/den
+  TRACE_SWAP,    // rows tangleA and tangleB exchanged
+  TRACE_REMOVE,  // row tangleA slid to tangleB when compacting, -1 if removed
+  TRACE_END      // tangleA status, tangleB classification, num/den if rational
+};
+
+typedef struct traceEvent {
+  uint8_t kind;
+  int8_t clock1;
+  int8_t clock2;
+  uint8_t reserved;
+  uint32_t sequence;   // low bits of the event's number in its ring
+  int32_t tangleA;
+  int32_t tangleB;
+  int64_t num;
+  int64_t den;
+} traceEvent;
+
+typedef struct traceRing {
+  traceEvent *events;
+  uint64_t head;       // events recorded; the next goes at head % TRACE_RING_EVENTS
+  int64_t label;       // put in the next TRACE_BEGIN, the input line in batch mode
+} traceRing;
+
+/* The file traceWrite makes is this header, then each ring as a traceRingHeader and its events */
+typedef struct traceFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t rings;
+} traceFileHeader;
+
+typedef struct traceRingHeader {
+  uint32_t ring;
+  uint32_t eventSize;
+  uint64_t recorded;   // events ever recorded, more than count when the ring wrapped
+  uint64_t count;      // events that follow, oldest first
+} traceRingHeader;
+
+int traceInit(traceRing *ring);
+void traceFree(traceRing *ring);
+int traceWrite(FILE *out, const traceRing rings[], int count);
+
+static inline void traceRecord(traceRing *ring, int kind, int tangleA, int tangleB,
+                               int clock1, int clock2, tangleInt num, tangleInt den) {
+  traceEvent *event = &ring->events[ring->head & (TRACE_RING_EVENTS - 1)];
+  event->kind = kind;
+  event->clock1 = clock1;
+  event->clock2 = clock2;
+  event->reserved = 0;
+  event->sequence = (uint32_t)ring->head;
+  event->tangleA = tangleA;
+  event->tangleB = tangleB;
+  event->num = num;
+  event->den = den;
+  ring->head++;
+}
+
+#ifdef CONWAY_TRACE
+/* The ring this thread records into, NULL when it is not tracing */
+extern _Thread_local traceRing *activeTrace;
+
+#define TRACE_ATTACH(ring) (activeTrace = (ring))
+#define TRACE(kind, tangleA, tangleB, clock1, clock2, num, den) do { \
+    if (activeTrace != NULL) \
+      traceRecord(activeTrace, kind, tangleA, tangleB, clock1, clock2, num, den); \
+  } while (0)
+#else
+#define TRACE_ATTACH(ring) ((void)(ring))
+#define TRACE(kind, tangleA, tangleB, clock1, clock2, num, den) do {} while (0)
+#endif
@@ -17,34 +17,83 @@ void display(int row, int cols, int * matrix) {
   do {} while (0);
 }
 #endif*/
-int aModB(int a, int b){
+tangleInt aModB(tangleInt a, tangleInt b){
   a = a%b;
   if (a < 0){
     a += b;
   }
   return a;
 }
-/* ainversemodb finds an X such that X*b = 1 (mod a) */
-int ainversemodb(int b, int a) {
-  int X = 0;
-  if (abs(a)==1){
-    return a;
-  } else if (a < -1){
-    for(int i = -1; i > a; i--){
-      if((i * b - 1)  % a == 0){
-        X = i - a;
-      }
-    }
+/*
+  Extended Euclid: returns g = gcd(|a|, |b|) and fills *x, *y so that
+  a*x + b*y = g. The coefficients stay below |a| and |b|, so they fit
+  whenever a and b do.
+*/
+tangleInt bezout(tangleInt a, tangleInt b, tangleInt *x, tangleInt *y){
+  tangleInt oldR = a, r = b;
+  tangleInt oldX = 1, X = 0;
+  tangleInt oldY = 0, Y = 1;
+  while (r != 0){
+    tangleInt q = oldR / r;
+    tangleInt t = oldR - q * r;
+    oldR = r;
+    r = t;
+    t = oldX - q * X;
+    oldX = X;
+    X = t;
+    t = oldY - q * Y;
+    oldY = Y;
+    Y = t;
   }
-  else {
-    for (int i = 1; i < a; i++) {
-      if ((i * b - 1) % a == 0){
-        X = i;
-      }
-    }
+  if (oldR < 0){
+    oldR = -oldR;
+    oldX = -oldX;
+    oldY = -oldY;
+  }
+  *x = oldX;
+  *y = oldY;
+  return oldR;
+}
+
+/*
+  ainversemodb finds an X in [1, |a|) such that X*b = 1 (mod a). Returns 0,
+  or -1 when there is none: a is 0 or shares a factor with b.
+*/
+int ainversemodb(tangleInt b, tangleInt a, tangleInt *inverse) {
+  tangleInt X, Y;
+  if (llabs(a)==1){
+    *inverse = a;
+    return 0;
+  }
+  if (a == 0 || bezout(b, a, &X, &Y) != 1){
+    return -1;
   }
-  if (X == 0){
-    printf("ainvermodb broke with values %d, %d\n", b, a);
+  *inverse = aModB(X, llabs(a));
+  return 0;
+}
+
+/*
+  Writes the convergents p[k]/q[k] of the continued fraction of a/b, b > 0,
+  and returns how many there are (at most max). The last one is a/b in
+  lowest terms, and the one before it is the inverse: p[n-1]*q[n-2] -
+  p[n-2]*q[n-1] = (-1)^n.
+*/
+int convergents(tangleInt a, tangleInt b, tangleInt p[], tangleInt q[], int max){
+  tangleInt p1 = 1, q1 = 0;  // p[k-1], q[k-1]
+  tangleInt p2 = 0, q2 = 1;  // p[k-2], q[k-2]
+  int n = 0;
+  while (b != 0 && n < max){
+    tangleInt r = aModB(a, b);
+    tangleInt A = (a - r) / b;  // floor of a/b, also for negative a
+    p[n] = A * p1 + p2;
+    q[n] = A * q1 + q2;
+    p2 = p1;
+    q2 = q1;
+    p1 = p[n];
+    q1 = q[n];
+    n++;
+    a = b;
+    b = r;
   }
-  return X;
+  return n;
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "fraction.h"
+
 #ifdef DEBUG
     #define DEBUG_PRINTF(...) printf("DEBUG: "__VA_ARGS__)
 #else
@@ -8,6 +10,10 @@
 
 void display(int row, int cols, int * matrix);
 
-int ainversemodb(int b, int a);
+tangleInt bezout(tangleInt a, tangleInt b, tangleInt *x, tangleInt *y);
+
+int ainversemodb(tangleInt b, tangleInt a, tangleInt *inverse);
+
+int convergents(tangleInt a, tangleInt b, tangleInt p[], tangleInt q[], int max);
 
-int aModB(int a, int b);
+tangleInt aModB(tangleInt a, tangleInt b);
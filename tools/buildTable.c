@@ -0,0 +1,86 @@
+#include "../src/canonical.h"
+#include "../src/generate.h"
+#include "../src/lookup.h"
+#include "../src/pdToConwayTangles.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+  Builds the table pdToConwayTangles -t looks small tangles up in: every PD
+  code generateDiagrams writes of up to maxCrossings crossings (default 4),
+  reduced once for each canonical form:
+
+    make table, or make tools && tools/buildTable tangles.table [maxCrossings]
+
+  Up to 4 crossings there are some 630 thousand canonical codes and the
+  table takes 16MB. Each crossing more multiplies both by about 30.
+*/
+
+typedef struct buildState {
+  lookupBuilder builder;
+  arena scratch;
+  tangleResult result;
+  long codes;
+  int failed;
+} buildState;
+
+static void addCode(void *context, const char *name, int shape, int rows, tangleInt pdCode[][7]) {
+  buildState *build = context;
+  uint64_t key[2];
+
+  (void)name;
+  (void)shape;
+  build->codes++;
+  if (build->failed || canonicalPD(rows, pdCode, &build->scratch) != 0) {
+    return;
+  }
+  hashPD(rows, pdCode, key);
+  if (lookupContains(&build->builder, key)) {
+    return;
+  }
+  pdToConwayArena(rows, pdCode, &build->result, &build->scratch);
+  if (lookupAdd(&build->builder, key, &build->result) != 0) {
+    perror("lookupAdd");
+    build->failed = 1;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2 || argc > 3) {
+    fprintf(stderr, "usage: %s table [maxCrossings]\n", argv[0]);
+    return 1;
+  }
+  int maxCrossings = argc > 2 ? atoi(argv[2]) : 4;
+  buildState *build = malloc(sizeof(buildState));
+  struct timespec begin, end;
+
+  if (build == NULL || lookupBuilderInit(&build->builder) != 0) {
+    perror("buildTable");
+    return 1;
+  }
+  arenaInit(&build->scratch);
+  build->codes = 0;
+  build->failed = 0;
+  clock_gettime(CLOCK_MONOTONIC, &begin);
+  long records = generateDiagrams(maxCrossings, addCode, build);
+  if (records < 0) {
+    perror("generateDiagrams");
+  }
+  int status = records < 0 || build->failed;
+  if (!status && lookupWrite(&build->builder, argv[1], maxCrossings) != 0) {
+    perror(argv[1]);
+    status = 1;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  if (!status) {
+    double seconds = (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9;
+    fprintf(stderr, "%ld codes of up to %d crossings, %lu canonical, %lu distinct results, "
+            "in %.1f s\n", build->codes, maxCrossings, (unsigned long)build->builder.keyCount,
+            (unsigned long)build->builder.recordCount, seconds);
+  }
+  arenaFree(&build->scratch);
+  lookupBuilderFree(&build->builder);
+  free(build);
+  return status;
+}
@@ -0,0 +1,21 @@
+#include "../src/store.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+  Rewrites a result store written by pdToConwayTangles -b -s into a new
+  file, packing its rows and optionally resizing it:
+
+    make tools && tools/compactStore old.store new.store [slots [dataBytes]]
+
+  Run it while no batch is writing to the old store.
+*/
+int main(int argc, char *argv[]) {
+  if (argc < 3 || argc > 5) {
+    fprintf(stderr, "usage: %s from to [slots [dataBytes]]\n", argv[0]);
+    return 1;
+  }
+  uint64_t slots = argc > 3 ? strtoull(argv[3], NULL, 10) : 0;
+  uint64_t dataSize = argc > 4 ? strtoull(argv[4], NULL, 10) : 0;
+  return storeCompact(argv[1], argv[2], slots, dataSize) == 0 ? 0 : 1;
+}
@@ -0,0 +1,113 @@
+#include "../src/trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+  Prints the events of a trace written by pdToConwayTangles -T, one per line,
+  ring by ring and oldest first:
+
+    make TRACE=1 && pdToConwayTangles -b -T run.trace pdCodes.txt > out.csv
+    make tools && tools/traceDecode run.trace [line]
+
+  Given a line, only the reductions of the tangle on that input line are
+  printed. A ring that wrapped starts partway into a reduction, whose events
+  are printed without the tangle they belong to.
+*/
+static const char *kindNames[] = {"begin", "merge", "rotate", "swap", "remove", "end"};
+
+static void printEvent(const traceEvent *event) {
+  printf("%10u %-6s ", event->sequence,
+         event->kind <= TRACE_END ? kindNames[event->kind] : "?");
+  switch (event->kind) {
+  case TRACE_BEGIN:
+    printf("line %lld, %d crossings\n", (long long)event->num, event->tangleA);
+    break;
+  case TRACE_MERGE:
+    if (event->clock1 < 0) {
+      printf("%d into %d -> %lld/%lld\n", event->tangleA, event->tangleB,
+             (long long)event->num, (long long)event->den);
+    } else {
+      printf("%d into %d at clocks %d,%d -> %lld/%lld\n", event->tangleA, event->tangleB,
+             event->clock1, event->clock2, (long long)event->num, (long long)event->den);
+    }
+    break;
+  case TRACE_ROTATE:
+    printf("%d by %d quarter turns, %lld/%lld\n", event->tangleA, event->clock1,
+           (long long)event->num, (long long)event->den);
+    break;
+  case TRACE_SWAP:
+    printf("%d and %d\n", event->tangleA, event->tangleB);
+    break;
+  case TRACE_REMOVE:
+    if (event->tangleB < 0) {
+      printf("%d removed\n", event->tangleA);
+    } else {
+      printf("%d moved to %d, %lld/%lld\n", event->tangleA, event->tangleB,
+             (long long)event->num, (long long)event->den);
+    }
+    break;
+  case TRACE_END:
+    printf("status %d, class %d, %lld/%lld\n", event->tangleA, event->tangleB,
+           (long long)event->num, (long long)event->den);
+    break;
+  default:
+    printf("%d %d %d %d %lld %lld\n", event->tangleA, event->tangleB, event->clock1,
+           event->clock2, (long long)event->num, (long long)event->den);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2 || argc > 3) {
+    fprintf(stderr, "usage: %s trace [line]\n", argv[0]);
+    return 1;
+  }
+  FILE *in = fopen(argv[1], "rb");
+  if (in == NULL) {
+    perror(argv[1]);
+    return 1;
+  }
+  int filtered = argc > 2;
+  long long line = filtered ? atoll(argv[2]) : 0;
+
+  traceFileHeader header;
+  if (fread(&header, sizeof(header), 1, in) != 1 ||
+      memcmp(header.magic, TRACE_MAGIC, 8) != 0 || header.version != TRACE_VERSION) {
+    fprintf(stderr, "%s: not a version %d trace\n", argv[1], TRACE_VERSION);
+    fclose(in);
+    return 1;
+  }
+  for (uint32_t r = 0; r < header.rings; r++) {
+    traceRingHeader ring;
+    if (fread(&ring, sizeof(ring), 1, in) != 1 || ring.eventSize != sizeof(traceEvent)) {
+      fprintf(stderr, "%s: truncated at ring %u\n", argv[1], r);
+      fclose(in);
+      return 1;
+    }
+    if (!filtered) {
+      printf("ring %u: %llu events, %llu older ones overwritten\n", ring.ring,
+             (unsigned long long)ring.count, (unsigned long long)(ring.recorded - ring.count));
+    }
+    // Until the first begin the tangle is unknown, so a filter shows nothing
+    int showing = !filtered;
+    for (uint64_t i = 0; i < ring.count; i++) {
+      traceEvent event;
+      if (fread(&event, sizeof(event), 1, in) != 1) {
+        fprintf(stderr, "%s: truncated in ring %u\n", argv[1], r);
+        fclose(in);
+        return 1;
+      }
+      if (filtered && event.kind == TRACE_BEGIN) {
+        showing = event.num == line;
+        if (showing) {
+          printf("ring %u:\n", ring.ring);
+        }
+      }
+      if (showing) {
+        printEvent(&event);
+      }
+    }
+  }
+  fclose(in);
+  return 0;
+}